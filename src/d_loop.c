@@ -95,6 +95,12 @@ fixed_t         offsetms;
 
 static boolean  new_sync = true;
 
+// [crispy] Draw frames between tics, interpolating from the previous
+// tic by fractionaltic.
+
+int             uncapped = 1;
+fixed_t         fractionaltic = FRACUNIT;
+
 // Callback functions for loop code.
 
 static loop_interface_t *loop_interface = NULL;
@@ -366,6 +372,24 @@ static void SinglePlayerClear(ticcmd_set_t *set)
 // TryRunTics
 //
 
+//
+// D_SetFractionalTic
+// [crispy] How far the clock has moved into the current tic.
+//
+void D_SetFractionalTic (void)
+{
+    if (uncapped && !singletics)
+    {
+        const int64_t ms = (int64_t) I_GetTimeMS() * TICRATE;
+
+        fractionaltic = (ms % 1000) * FRACUNIT / 1000;
+    }
+    else
+    {
+        fractionaltic = FRACUNIT;
+    }
+}
+
 void TryRunTics (void)
 {
     int	i;
@@ -402,6 +426,14 @@ void TryRunTics (void)
     if (new_sync)
     {
 	counts = availabletics;
+
+        // [AM] If we've uncapped the framerate and there are no tics
+        //      to run, return early instead of waiting around.
+        if (uncapped && !singletics && counts == 0)
+        {
+            D_SetFractionalTic();
+            return;
+        }
     }
     else
     {
@@ -454,6 +486,8 @@ void TryRunTics (void)
 
 	NetUpdate ();	// check for new console commands
     }
+
+    D_SetFractionalTic();
 }
 
 void D_RegisterLoopCallbacks(loop_interface_t *i)
@@ -20,6 +20,7 @@
 #define __D_LOOP__
 
 #include "net_defs.h"
+#include "m_fixed.h"
 
 // Callback function invoked while waiting for the netgame to start.
 // The callback is invoked when new players are ready. The callback
@@ -61,6 +62,9 @@ void D_QuitNetGame (void);
 //? how many ticks to run?
 void TryRunTics (void);
 
+// How far the clock is into the current tic, for interpolation.
+void D_SetFractionalTic (void);
+
 // Called at start of game loop to initialize timers
 void D_StartGameLoop(void);
 
@@ -77,6 +81,9 @@ void D_StartNetGame(net_gamesettings_t *settings,
 extern boolean singletics;
 extern int gametic, ticdup;
 
+extern int uncapped;
+extern fixed_t fractionaltic;
+
 // Check if it is permitted to record a demo with a non-vanilla feature.
 boolean D_NonVanillaRecord(boolean conditional, char *feature);
 
@@ -1001,22 +1001,23 @@ AM_clipMline
 
 
 //
-// Classic Bresenham w/ whatever optimizations needed for speed
+// [crispy] Draws a clipped line.
+// Horizontal and vertical lines are filled in one go, anything else
+//  steps along its major axis with the minor coordinate kept in fixed
+//  point, which reaches the same end points as Bresenham without its
+//  per-pixel decision.
 //
 void
 AM_drawFline
 ( fline_t*	fl,
   int		color )
 {
-    register int x;
-    register int y;
-    register int dx;
-    register int dy;
-    register int sx;
-    register int sy;
-    register int ax;
-    register int ay;
-    register int d;
+    int		dx;
+    int		dy;
+    int		ax;
+    int		ay;
+    int		i;
+    pixel_t*	dest;
     
     static int fuck = 0;
 
@@ -1030,50 +1031,42 @@ AM_drawFline
 	return;
     }
 
-#define PUTDOT(xx,yy,cc) fb[(yy)*f_w+(xx)]=(cc)
-
     dx = fl->b.x - fl->a.x;
-    ax = 2 * (dx<0 ? -dx : dx);
-    sx = dx<0 ? -1 : 1;
-
     dy = fl->b.y - fl->a.y;
-    ay = 2 * (dy<0 ? -dy : dy);
-    sy = dy<0 ? -1 : 1;
+    ax = dx < 0 ? -dx : dx;
+    ay = dy < 0 ? -dy : dy;
 
-    x = fl->a.x;
-    y = fl->a.y;
+    if (!dy)
+    {
+	memset(fb + fl->a.y*f_w + MIN(fl->a.x, fl->b.x), color, ax + 1);
+    }
+    else if (!dx)
+    {
+	dest = fb + MIN(fl->a.y, fl->b.y)*f_w + fl->a.x;
 
-    if (ax > ay)
+	for (i = 0; i <= ay; i++, dest += f_w)
+	    *dest = color;
+    }
+    else if (ax > ay)
     {
-	d = ay - ax/2;
-	while (1)
-	{
-	    PUTDOT(x,y,color);
-	    if (x == fl->b.x) return;
-	    if (d>=0)
-	    {
-		y += sy;
-		d -= ax;
-	    }
-	    x += sx;
-	    d += ay;
-	}
+	const int sx = dx < 0 ? -1 : 1;
+	const fixed_t ystep = (dy << FRACBITS) / ax;
+	fixed_t y = (fl->a.y << FRACBITS) + FRACUNIT/2;
+	int x = fl->a.x;
+
+	for (i = 0; i <= ax; i++, x += sx, y += ystep)
+	    fb[(y >> FRACBITS)*f_w + x] = color;
     }
     else
     {
-	d = ax - ay/2;
-	while (1)
-	{
-	    PUTDOT(x, y, color);
-	    if (y == fl->b.y) return;
-	    if (d >= 0)
-	    {
-		x += sx;
-		d -= ay;
-	    }
-	    y += sy;
-	    d += ax;
-	}
+	const int sy = dy < 0 ? -f_w : f_w;
+	const fixed_t xstep = (dx << FRACBITS) / ay;
+	fixed_t x = (fl->a.x << FRACBITS) + FRACUNIT/2;
+
+	dest = fb + fl->a.y*f_w;
+
+	for (i = 0; i <= ay; i++, dest += sy, x += xstep)
+	    dest[x >> FRACBITS] = color;
     }
 }
 
@@ -1139,6 +1132,79 @@ void AM_drawGrid(int color)
 
 }
 
+//
+// [crispy] Automap line cache.
+// The lines inside the window are found through the blockmap, clipped
+//  and transformed once, and then redrawn from amvisible[] until the
+//  window is panned or zoomed.  Only their colors are decided anew in
+//  each frame, as lines get mapped and sectors move.
+//
+typedef struct
+{
+    line_t	*line;
+    fline_t	fl;
+} amline_t;
+
+static amline_t	*amvisible;
+static int	numamvisible;
+
+static struct
+{
+    fixed_t	x, y;
+    fixed_t	scale;
+    int		w, h;
+} amcache;
+
+static boolean AM_cacheLine (line_t *ld)
+{
+    mline_t l;
+
+    l.a.x = ld->v1->x;
+    l.a.y = ld->v1->y;
+    l.b.x = ld->v2->x;
+    l.b.y = ld->v2->y;
+
+    if (AM_clipMline(&l, &amvisible[numamvisible].fl))
+	amvisible[numamvisible++].line = ld;
+
+    return true;
+}
+
+static void AM_cacheLines (void)
+{
+    int bx, by;
+    int bx1, bx2, by1, by2;
+
+    if (amvisible
+     && amcache.x == m_x && amcache.y == m_y
+     && amcache.scale == scale_mtof
+     && amcache.w == f_w && amcache.h == f_h)
+	return;
+
+    // freed with the level
+    if (!amvisible)
+	Z_Malloc(numlines * sizeof(*amvisible), PU_LEVEL, &amvisible);
+
+    amcache.x = m_x;
+    amcache.y = m_y;
+    amcache.scale = scale_mtof;
+    amcache.w = f_w;
+    amcache.h = f_h;
+
+    numamvisible = 0;
+
+    bx1 = MAX((m_x - bmaporgx) >> MAPBLOCKSHIFT, 0);
+    bx2 = MIN((m_x2 - bmaporgx) >> MAPBLOCKSHIFT, bmapwidth - 1);
+    by1 = MAX((m_y - bmaporgy) >> MAPBLOCKSHIFT, 0);
+    by2 = MIN((m_y2 - bmaporgy) >> MAPBLOCKSHIFT, bmapheight - 1);
+
+    validcount++;
+
+    for (by = by1; by <= by2; by++)
+	for (bx = bx1; bx <= bx2; bx++)
+	    P_BlockLinesIterator(bx, by, AM_cacheLine);
+}
+
 //
 // Determines visible lines, draws them.
 // This is LineDef based, not LineSeg based.
@@ -1146,49 +1212,51 @@ void AM_drawGrid(int color)
 void AM_drawWalls(void)
 {
     int i;
-    static mline_t l;
+    line_t *line;
+    fline_t *fl;
+
+    AM_cacheLines();
 
-    for (i=0;i<numlines;i++)
+    for (i=0;i<numamvisible;i++)
     {
-	l.a.x = lines[i].v1->x;
-	l.a.y = lines[i].v1->y;
-	l.b.x = lines[i].v2->x;
-	l.b.y = lines[i].v2->y;
-	if (cheating || (lines[i].flags & ML_MAPPED))
+	line = amvisible[i].line;
+	fl = &amvisible[i].fl;
+
+	if (cheating || (line->flags & ML_MAPPED))
 	{
-	    if ((lines[i].flags & LINE_NEVERSEE) && !cheating)
+	    if ((line->flags & LINE_NEVERSEE) && !cheating)
 		continue;
-	    if (!lines[i].backsector)
+	    if (!line->backsector)
 	    {
-		AM_drawMline(&l, WALLCOLORS+lightlev);
+		AM_drawFline(fl, WALLCOLORS+lightlev);
 	    }
 	    else
 	    {
-		if (lines[i].special == 39)
+		if (line->special == 39)
 		{ // teleporters
-		    AM_drawMline(&l, WALLCOLORS+WALLRANGE/2);
+		    AM_drawFline(fl, WALLCOLORS+WALLRANGE/2);
 		}
-		else if (lines[i].flags & ML_SECRET) // secret door
+		else if (line->flags & ML_SECRET) // secret door
 		{
-		    if (cheating) AM_drawMline(&l, SECRETWALLCOLORS + lightlev);
-		    else AM_drawMline(&l, WALLCOLORS+lightlev);
+		    if (cheating) AM_drawFline(fl, SECRETWALLCOLORS + lightlev);
+		    else AM_drawFline(fl, WALLCOLORS+lightlev);
 		}
-		else if (lines[i].backsector->floorheight
-			   != lines[i].frontsector->floorheight) {
-		    AM_drawMline(&l, FDWALLCOLORS + lightlev); // floor level change
+		else if (line->backsector->floorheight
+			   != line->frontsector->floorheight) {
+		    AM_drawFline(fl, FDWALLCOLORS + lightlev); // floor level change
 		}
-		else if (lines[i].backsector->ceilingheight
-			   != lines[i].frontsector->ceilingheight) {
-		    AM_drawMline(&l, CDWALLCOLORS+lightlev); // ceiling level change
+		else if (line->backsector->ceilingheight
+			   != line->frontsector->ceilingheight) {
+		    AM_drawFline(fl, CDWALLCOLORS+lightlev); // ceiling level change
 		}
 		else if (cheating) {
-		    AM_drawMline(&l, TSWALLCOLORS+lightlev);
+		    AM_drawFline(fl, TSWALLCOLORS+lightlev);
 		}
 	    }
 	}
 	else if (plr->powers[pw_allmap])
 	{
-	    if (!(lines[i].flags & LINE_NEVERSEE)) AM_drawMline(&l, GRAYS+3);
+	    if (!(line->flags & LINE_NEVERSEE)) AM_drawFline(fl, GRAYS+3);
 	}
     }
 }
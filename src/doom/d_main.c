@@ -310,12 +310,12 @@ void D_Display (void)
 	        break;
 	    if (automapactive)
 	        AM_Drawer ();
-	    if (wipe || (viewheight != SCREENHEIGHT && fullscreen))
+	    if (wipe || (scaledviewheight != SCREENHEIGHT && fullscreen))
 	        redrawsbar = true;
 	    if (inhelpscreensstate && !inhelpscreens)
 	        redrawsbar = true;              // just put away the help screen
-	    ST_Drawer (viewheight == SCREENHEIGHT, redrawsbar );
-	    fullscreen = viewheight == SCREENHEIGHT;
+	    ST_Drawer (scaledviewheight == SCREENHEIGHT, redrawsbar );
+	    fullscreen = scaledviewheight == SCREENHEIGHT;
 	    break;
 
       case GS_INTERMISSION:
@@ -463,6 +463,14 @@ void D_BindVariables(void)
     M_BindIntVariable("show_messages",          &showMessages);
     M_BindIntVariable("screenblocks",           &screenblocks);
     M_BindIntVariable("detaillevel",            &detailLevel);
+    M_BindIntVariable("render_threads",         &render_threads);
+    M_BindIntVariable("render_scale",           &render_scale);
+    M_BindIntVariable("render_governor",        &render_governor);
+    M_BindIntVariable("render_lod",             &render_lod);
+    M_BindIntVariable("render_stats",           &render_stats);
+    M_BindIntVariable("render_heatmap",         &render_heatmap);
+    M_BindIntVariable("render_pvs",             &render_pvs);
+    M_BindIntVariable("uncapped",               &uncapped);
     M_BindIntVariable("snd_channels",           &snd_channels);
     M_BindIntVariable("vanilla_savegame_limit", &vanilla_savegame_limit);
     M_BindIntVariable("vanilla_demo_limit",     &vanilla_demo_limit);
@@ -500,6 +508,8 @@ boolean D_GrabMouseCallback(void)
 
 void D_DoomLoopIter()
 {
+    const int frametime = I_GetTimeMS();
+
     if (wipestart > 0)
     {
         D_Display();
@@ -516,6 +526,11 @@ void D_DoomLoopIter()
     if (screenvisible)
     {
         D_Display ();
+
+        // [crispy] hold the frame rate by lowering the render scale
+        if (gamestate == GS_LEVEL && !automapactive && !menuactive)
+            R_GovernFrame (I_GetTimeMS() - frametime);
+
         if (inspectmode && firstScreen)
         {
             firstScreen = false;
@@ -89,6 +89,9 @@ typedef struct player_s
     fixed_t		viewheight;
     // Bob/squat speed.
     fixed_t         	deltaviewheight;
+    // [AM] Previous position of viewz before think.
+    //      Used to interpolate between camera positions.
+    fixed_t		oldviewz;
     // bounded/scaled total momentum.
     fixed_t         	bob;	
 
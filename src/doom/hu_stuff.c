@@ -36,6 +36,7 @@
 #include "m_argv.h" // [crispy] M_ParmExists()
 #include "st_stuff.h" // [crispy] ST_HEIGHT
 #include "p_setup.h" // maplumpinfo
+#include "r_main.h" // [crispy] renderstats
 
 #include "s_sound.h"
 
@@ -69,6 +70,11 @@
 #define HU_INPUTWIDTH	64
 #define HU_INPUTHEIGHT	1
 
+// [crispy] renderer statistics, below the chat input
+#define HU_RSTATSX	HU_MSGX
+#define HU_RSTATSY	(HU_INPUTY + HU_INPUTHEIGHT*(SHORT(hu_font[0]->height) +1))
+#define HU_RSTATSHEIGHT	4
+
 #define HU_COORDX	(ORIGWIDTH - 7 * hu_font['A'-HU_FONTSTART]->width)
 
 char *chat_macros[10] =
@@ -110,6 +116,8 @@ static boolean		message_nottobefuckedwith;
 static hu_stext_t	w_message;
 static int		message_counter;
 
+static hu_textline_t	w_rstats[HU_RSTATSHEIGHT]; // [crispy] renderer statistics
+
 extern int		showMessages;
 
 static boolean		headsupactive = false;
@@ -637,10 +645,57 @@ void HU_Start(void)
     for (i=0 ; i<MAXPLAYERS ; i++)
 	HUlib_initIText(&w_inputbuffer[i], 0, 0, 0, 0, &always_off);
 
+    // [crispy] create the renderer statistics widgets
+    for (i=0 ; i<HU_RSTATSHEIGHT ; i++)
+	HUlib_initTextLine(&w_rstats[i],
+			   HU_RSTATSX, HU_RSTATSY + i*(SHORT(hu_font[0]->height) +1),
+			   hu_font,
+			   HU_FONTSTART);
+
     headsupactive = true;
 
 }
 
+// [crispy] fill in and draw the renderer statistics of the last frame
+static void HU_DrawRenderStats (void)
+{
+    const renderstats_t *rs = &renderstats;
+    char str[HU_MAXLINELENGTH+1];
+    int i;
+
+    for (i=0 ; i<HU_RSTATSHEIGHT ; i++)
+    {
+	const char *s = str;
+
+	switch (i)
+	{
+	  case 0:
+	    M_snprintf(str, sizeof(str), "PLANES %d SEGS %d SPRITES %d",
+		       rs->visplanes, rs->drawsegs, rs->vissprites);
+	    break;
+	  case 1:
+	    M_snprintf(str, sizeof(str), "NODES %d CULLED %d EARLY %d",
+		       rs->nodes, rs->culled, rs->earlyouts);
+	    break;
+	  case 2:
+	    M_snprintf(str, sizeof(str), "COLUMNS %d SPANS %d PIXELS %d",
+		       rs->columns, rs->spans, rs->pixels);
+	    break;
+	  default:
+	    M_snprintf(str, sizeof(str), "BSP %d.%02d PLANES %d.%02d MASKED %d.%02d MS",
+		       rs->bsptime / 1000, rs->bsptime % 1000 / 10,
+		       rs->planetime / 1000, rs->planetime % 1000 / 10,
+		       rs->maskedtime / 1000, rs->maskedtime % 1000 / 10);
+	    break;
+	}
+
+	HUlib_clearTextLine(&w_rstats[i]);
+	while (*s)
+	    HUlib_addCharToTextLine(&w_rstats[i], *(s++));
+	HUlib_drawTextLine(&w_rstats[i], false);
+    }
+}
+
 void HU_Drawer(void)
 {
 
@@ -648,16 +703,22 @@ void HU_Drawer(void)
     HUlib_drawIText(&w_chat);
     if (automapactive)
 	HUlib_drawTextLine(&w_title, false);
+    else if (render_stats)
+	HU_DrawRenderStats();
 
 }
 
 void HU_Erase(void)
 {
+    int i;
 
     HUlib_eraseSText(&w_message);
     HUlib_eraseIText(&w_chat);
     HUlib_eraseTextLine(&w_title);
 
+    for (i=0 ; i<HU_RSTATSHEIGHT ; i++)
+	HUlib_eraseTextLine(&w_rstats[i]);
+
 }
 
 void HU_Ticker(void)
@@ -270,7 +270,7 @@ EV_DoDoor
 	
 	// new door thinker
 	rtn = 1;
-	door = Z_Malloc (sizeof(*door), PU_LEVSPEC, 0);
+	door = P_AllocateThinker (tp_door);
 	P_AddThinker (&door->thinker);
 	sec->ceilingdata = door;
 
@@ -477,7 +477,7 @@ EV_VerticalDoor
 	
     
     // new door thinker
-    door = Z_Malloc (sizeof(*door), PU_LEVSPEC, 0);
+    door = P_AllocateThinker (tp_door);
     P_AddThinker (&door->thinker);
     sec->ceilingdata = door;
     door->thinker.function.acp1 = (actionf_p1) T_VerticalDoor;
@@ -527,7 +527,7 @@ void P_SpawnDoorCloseIn30 (sector_t* sec)
 {
     vldoor_t*	door;
 	
-    door = Z_Malloc ( sizeof(*door), PU_LEVSPEC, 0);
+    door = P_AllocateThinker (tp_door);
 
     P_AddThinker (&door->thinker);
 
@@ -552,7 +552,7 @@ P_SpawnDoorRaiseIn5Mins
 {
     vldoor_t*	door;
 	
-    door = Z_Malloc ( sizeof(*door), PU_LEVSPEC, 0);
+    door = P_AllocateThinker (tp_door);
     
     P_AddThinker (&door->thinker);
 
@@ -49,6 +49,17 @@ T_MovePlane
 {
     boolean	flag;
     fixed_t	lastpos;
+
+    // [crispy] drops the sight results that depend on this sector
+    sector->planestamp = ++planemoves;
+
+    // [AM] Store old sector heights for interpolation.
+    if (sector->oldgametic != gametic)
+    {
+        sector->oldfloorheight = sector->floorheight;
+        sector->oldceilingheight = sector->ceilingheight;
+        sector->oldgametic = gametic;
+    }
 	
     switch(floorOrCeiling)
     {
@@ -346,7 +357,7 @@ EV_DoFloor
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = P_AllocateThinker (tp_floor);
 	P_AddThinker (&floor->thinker);
 	sec->floordata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -549,7 +560,7 @@ EV_BuildStairs
 	
 	// new floor thinker
 	rtn = 1;
-	floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	floor = P_AllocateThinker (tp_floor);
 	P_AddThinker (&floor->thinker);
 	sec->floordata = floor;
 	floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -605,7 +616,7 @@ EV_BuildStairs
 					
 		sec = tsec;
 		secnum = newsecnum;
-		floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+		floor = P_AllocateThinker (tp_floor);
 
 		P_AddThinker (&floor->thinker);
 
@@ -710,7 +721,7 @@ int EV_DoElevator
 
     // create and initialize new elevator thinker
     rtn = 1;
-    elevator = Z_Malloc (sizeof(*elevator), PU_LEVSPEC, 0);
+    elevator = P_AllocateThinker (tp_elevator);
     memset(elevator, 0, sizeof(*elevator));
     P_AddThinker (&elevator->thinker);
     sec->floordata = elevator; //jff 2/22/98
@@ -70,10 +70,64 @@
 // both the head and tail of the thinker list
 extern	thinker_t	thinkercap;	
 
+// [crispy] The thinkers of each class are also linked into a list of
+// their own, in the same order.  Removed thinkers stay in it until
+// they are freed, so the function still has to be checked.
+typedef enum
+{
+    th_mobj,
+    th_misc,
+    NUMTHINKERCLASSES
+} thclass_t;
+
+// [crispy] Every thinker is kept in a slot of a slab pool, see
+// P_AllocateThinker().  The links of the class lists live in the
+// slot rather than in thinker_t, so the mobj fields stay where they are.
+typedef struct thinkerslot_s
+{
+    struct thinkerslot_s*	nextfree;
+    struct thinkerslot_s*	cprev;
+    struct thinkerslot_s*	cnext;
+    int				pool;	// -1 for the heads of the class lists
+    // the thinker follows
+} thinkerslot_t;
+
+extern	thinkerslot_t	thinkerclasscap[NUMTHINKERCLASSES];
+
+#define THINKERSLOT(th)	((thinkerslot_t *) (th) - 1)
+
+static inline thinker_t* P_SlotThinker (thinkerslot_t* slot)
+{
+    return slot->pool < 0 ? NULL : (thinker_t *) (slot + 1);
+}
+
+// for (th = P_FirstClassThinker(class) ; th ; th = P_NextClassThinker(th))
+#define P_FirstClassThinker(class)	P_SlotThinker(thinkerclasscap[class].cnext)
+#define P_NextClassThinker(th)		P_SlotThinker(THINKERSLOT(th)->cnext)
+
+
+// [crispy] the slab pools the thinkers come from
+typedef enum
+{
+    tp_mobj,
+    tp_ceiling,
+    tp_door,
+    tp_floor,
+    tp_plat,
+    tp_elevator,
+    tp_fireflicker,
+    tp_lightflash,
+    tp_strobe,
+    tp_glow,
+    NUMTHINKERPOOLS
+} thinkerpool_t;
 
 void P_InitThinkers (void);
 void P_AddThinker (thinker_t* thinker);
 void P_RemoveThinker (thinker_t* thinker);
+void* P_AllocateThinker (thinkerpool_t pool);
+void P_FreeThinker (thinker_t* thinker);
+void P_ReleaseThinkers (void);
 
 
 //
@@ -234,6 +288,11 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+
+// Bumped to drop all the results P_CheckSight() has kept.
+extern int	sightstamp;
+// Counts the moves of floors and ceilings, see sector_t planestamp.
+extern int	planemoves;
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
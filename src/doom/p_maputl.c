@@ -660,10 +660,27 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
 }
 
 
+// [crispy] sort keys for P_TraverseIntercepts(): the fraction
+// in the high word, the index of the intercept in the low word
+static int64_t*	interceptkeys;
+static int	numinterceptkeys;
+
+static int P_CompareInterceptKeys (const void *a, const void *b)
+{
+    const int64_t ka = *(const int64_t *) a;
+    const int64_t kb = *(const int64_t *) b;
+
+    return (ka > kb) - (ka < kb);
+}
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
 // for all lines.
+// [crispy] The intercepts are sorted once instead of searching for
+// the closest one again after each.  The index breaks ties between
+// equal fractions, so they are visited first-added first, exactly
+// as the search used to pick them.
 // 
 boolean
 P_TraverseIntercepts
@@ -671,27 +688,28 @@ P_TraverseIntercepts
   fixed_t	maxfrac )
 {
     int			count;
-    fixed_t		dist;
-    intercept_t*	scan;
+    int			i;
     intercept_t*	in;
 	
     count = intercept_p - intercepts;
-    
-    in = 0;			// shut up compiler warning
-	
-    while (count--)
+
+    if (count > numinterceptkeys)
     {
-	dist = INT_MAX;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
-	{
-	    if (scan->frac < dist)
-	    {
-		dist = scan->frac;
-		in = scan;
-	    }
-	}
+	numinterceptkeys = MAX(count, 2 * numinterceptkeys);
+	interceptkeys = I_Realloc(interceptkeys, numinterceptkeys * sizeof(*interceptkeys));
+    }
+
+    for (i = 0 ; i < count ; i++)
+	interceptkeys[i] = ((int64_t) intercepts[i].frac << 32) | i;
+
+    qsort(interceptkeys, count, sizeof(*interceptkeys), P_CompareInterceptKeys);
 	
-	if (dist > maxfrac)
+    for (i = 0 ; i < count ; i++)
+    {
+	in = &intercepts[interceptkeys[i] & 0xffffffff];
+
+	// the search never picked an intercept at INT_MAX
+	if (in->frac > maxfrac || in->frac == INT_MAX)
 	    return true;	// checked everything in range		
 
         if ( !func (in) )
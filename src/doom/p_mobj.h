@@ -204,6 +204,12 @@ typedef enum
 
 
 // Map Object definition.
+// [crispy] The fields are grouped by how often the thinkers and the
+// blockmap iterators touch them: what every tic of movement and every
+// PIT_ function reads comes first, what only some actions use follows,
+// and the spawn point and interpolation history are last.  The order
+// of the savegame is kept by p_saveg.c, which writes field by field.
+// x, y and z must follow the thinker, as in degenmobj_t.
 typedef struct mobj_s
 {
     // List: thinker links.
@@ -214,54 +220,60 @@ typedef struct mobj_s
     fixed_t		y;
     fixed_t		z;
 
-    // More list: links in sector (if needed)
-    struct mobj_s*	snext;
-    struct mobj_s*	sprev;
+    // For movement checking.
+    fixed_t		radius;
+    fixed_t		height;	
 
-    //More drawing info: to determine current sprite.
-    angle_t		angle;	// orientation
-    spritenum_t		sprite;	// used to find patch_t and flip value
-    int			frame;	// might be ORed with FF_FULLBRIGHT
+    int			flags;
 
     // Interaction info, by BLOCKMAP.
     // Links in blocks (if needed).
     struct mobj_s*	bnext;
     struct mobj_s*	bprev;
-    
+
+    // Momentums, used to update position.
+    fixed_t		momx;
+    fixed_t		momy;
+    fixed_t		momz;
+
+    int			tics;	// state tic counter
+    state_t*		state;
+
     struct subsector_s*	subsector;
 
     // The closest interval over all contacted Sectors.
     fixed_t		floorz;
     fixed_t		ceilingz;
 
-    // For movement checking.
-    fixed_t		radius;
-    fixed_t		height;	
-
-    // Momentums, used to update position.
-    fixed_t		momx;
-    fixed_t		momy;
-    fixed_t		momz;
+    // More list: links in sector (if needed)
+    struct mobj_s*	snext;
+    struct mobj_s*	sprev;
 
     // If == validcount, already checked.
     int			validcount;
 
     mobjtype_t		type;
     mobjinfo_t*		info;	// &mobjinfo[mobj->type]
-    
-    int			tics;	// state tic counter
-    state_t*		state;
-    int			flags;
-    int			health;
 
-    // Movement direction, movement generation (zig-zagging).
-    int			movedir;	// 0-7
-    int			movecount;	// when 0, select a new dir
+    // Additional info record for player avatars only.
+    // Only valid if type == MT_PLAYER
+    struct player_s*	player;
 
     // Thing being chased/attacked (or NULL),
     // also the originator for missiles.
     struct mobj_s*	target;
 
+    //More drawing info: to determine current sprite.
+    angle_t		angle;	// orientation
+    spritenum_t		sprite;	// used to find patch_t and flip value
+    int			frame;	// might be ORed with FF_FULLBRIGHT
+
+    int			health;
+
+    // Movement direction, movement generation (zig-zagging).
+    int			movedir;	// 0-7
+    int			movecount;	// when 0, select a new dir
+
     // Reaction time: if non 0, don't attack yet.
     // Used by player to freeze a bit after teleporting.
     int			reactiontime;   
@@ -270,18 +282,24 @@ typedef struct mobj_s
     // no matter what (even if shot)
     int			threshold;
 
-    // Additional info record for player avatars only.
-    // Only valid if type == MT_PLAYER
-    struct player_s*	player;
-
     // Player number last looked for.
     int			lastlook;	
 
+    // Thing being chased/attacked for tracers.
+    struct mobj_s*	tracer;	
+
     // For nightmare respawn.
     mapthing_t		spawnpoint;	
 
-    // Thing being chased/attacked for tracers.
-    struct mobj_s*	tracer;	
+    // [AM] If true, ok to interpolate this tic.
+    boolean		interp;
+
+    // [AM] Previous position of mobj before think.
+    //      Used to interpolate between positions.
+    fixed_t		oldx;
+    fixed_t		oldy;
+    fixed_t		oldz;
+    angle_t		oldangle;
     
 } mobj_t;
 
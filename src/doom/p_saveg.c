@@ -1534,6 +1534,8 @@ void P_UnArchiveWorld (void)
     line_t*		li;
     side_t*		si;
     
+    sightstamp++;
+
     // do sectors
     for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
     {
@@ -1593,7 +1595,7 @@ void P_ArchiveThinkers (void)
     thinker_t*		th;
 
     // save off the current thinkers
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    for (th = P_FirstClassThinker(th_mobj) ; th ; th = P_NextClassThinker(th))
     {
 	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 	{
@@ -1631,8 +1633,8 @@ void P_UnArchiveThinkers (void)
 	
 	if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
 	    P_RemoveMobj ((mobj_t *)currentthinker);
-	else
-	    Z_Free (currentthinker);
+
+	P_FreeThinker (currentthinker);
 
 	currentthinker = next;
     }
@@ -1649,9 +1651,12 @@ void P_UnArchiveThinkers (void)
 			
 	  case tc_mobj:
 	    saveg_read_pad();
-	    mobj = Z_Malloc (sizeof(*mobj), PU_LEVEL, NULL);
+	    mobj = P_AllocateThinker (tp_mobj);
             saveg_read_mobj_t(mobj);
 
+	    // [AM] Do not interpolate on the first tic after loading.
+	    mobj->interp = false;
+
 	    mobj->target = NULL;
             mobj->tracer = NULL;
 	    P_SetThingPosition (mobj);
@@ -1706,7 +1711,7 @@ void P_ArchiveSpecials (void)
     int			i;
 	
     // save off the current thinkers
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    for (th = P_FirstClassThinker(th_misc) ; th ; th = P_NextClassThinker(th))
     {
 	if (th->function.acv == (actionf_v)NULL)
 	{
@@ -1813,7 +1818,7 @@ void P_UnArchiveSpecials (void)
 			
 	  case tc_ceiling:
 	    saveg_read_pad();
-	    ceiling = Z_Malloc (sizeof(*ceiling), PU_LEVEL, NULL);
+	    ceiling = P_AllocateThinker (tp_ceiling);
             saveg_read_ceiling_t(ceiling);
 	    ceiling->sector->ceilingdata = ceiling;
 
@@ -1826,7 +1831,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_door:
 	    saveg_read_pad();
-	    door = Z_Malloc (sizeof(*door), PU_LEVEL, NULL);
+	    door = P_AllocateThinker (tp_door);
             saveg_read_vldoor_t(door);
 	    door->sector->ceilingdata = door;
 	    door->thinker.function.acp1 = (actionf_p1)T_VerticalDoor;
@@ -1835,7 +1840,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_floor:
 	    saveg_read_pad();
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVEL, NULL);
+	    floor = P_AllocateThinker (tp_floor);
             saveg_read_floormove_t(floor);
 	    floor->sector->floordata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -1844,7 +1849,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_plat:
 	    saveg_read_pad();
-	    plat = Z_Malloc (sizeof(*plat), PU_LEVEL, NULL);
+	    plat = P_AllocateThinker (tp_plat);
             saveg_read_plat_t(plat);
 	    plat->sector->floordata = plat;
 
@@ -1857,7 +1862,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_flash:
 	    saveg_read_pad();
-	    flash = Z_Malloc (sizeof(*flash), PU_LEVEL, NULL);
+	    flash = P_AllocateThinker (tp_lightflash);
             saveg_read_lightflash_t(flash);
 	    flash->thinker.function.acp1 = (actionf_p1)T_LightFlash;
 	    P_AddThinker (&flash->thinker);
@@ -1865,7 +1870,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_strobe:
 	    saveg_read_pad();
-	    strobe = Z_Malloc (sizeof(*strobe), PU_LEVEL, NULL);
+	    strobe = P_AllocateThinker (tp_strobe);
             saveg_read_strobe_t(strobe);
 	    strobe->thinker.function.acp1 = (actionf_p1)T_StrobeFlash;
 	    P_AddThinker (&strobe->thinker);
@@ -1873,7 +1878,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_glow:
 	    saveg_read_pad();
-	    glow = Z_Malloc (sizeof(*glow), PU_LEVEL, NULL);
+	    glow = P_AllocateThinker (tp_glow);
             saveg_read_glow_t(glow);
 	    glow->thinker.function.acp1 = (actionf_p1)T_Glow;
 	    P_AddThinker (&glow->thinker);
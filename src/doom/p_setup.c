@@ -1258,6 +1258,8 @@ P_SetupLevel
     // Make sure all sounds are stopped before Z_FreeTags.
     S_Start ();
 
+    // [crispy] the thinker pools go with the level's zone memory
+    P_ReleaseThinkers ();
     Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
 
     // UNUSED W_Profile ();
@@ -1272,6 +1274,7 @@ P_SetupLevel
     strncpy(lumpname, maplumpinfo->name, 8);
 
     leveltime = 0;
+    oldleveltime = 0;
     
     // [crispy] check and log map and nodes format
     crispy_mapformat = P_CheckMapFormat(lumpnum);
@@ -1316,6 +1319,10 @@ P_SetupLevel
 
     P_GroupLines ();
     P_LoadReject (lumpnum+ML_REJECT);
+    // [crispy] potentially visible sets for the renderer
+    R_BuildPVS (lumpnum);
+    // [crispy] drop the sight results kept for the last level
+    sightstamp++;
 
     // [crispy] remove slime trails
     P_RemoveSlimeTrails();
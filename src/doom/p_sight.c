@@ -18,6 +18,8 @@
 
 
 
+#include <string.h>
+
 #include "doomdef.h"
 
 #include "i_system.h"
@@ -39,6 +41,55 @@ fixed_t		t2y;
 
 int		sightcounts[2];
 
+// Results kept for the same two things at the same places, until a
+// floor or ceiling moves in one of the sectors the trace looked at.
+#define SIGHTMEMOSIZE	256
+#define SIGHTSECTORS	16	// traces that look at more are not kept
+
+typedef struct
+{
+    mobj_t*	t1;
+    mobj_t*	t2;
+    subsector_t* ss1;
+    subsector_t* ss2;
+    fixed_t	x1, y1, z1, h1;
+    fixed_t	x2, y2, z2, h2;
+    int		stamp;
+    int		moves;
+    int		numsectors;
+    sector_t*	sectors[SIGHTSECTORS];
+    boolean	result;
+} sightmemo_t;
+
+static sightmemo_t	sightmemo[SIGHTMEMOSIZE];
+int		sightstamp = 1;
+int		planemoves;
+
+// the sectors whose heights the current trace has looked at
+static sector_t*	sightsectors[SIGHTSECTORS];
+static int		numsightsectors;
+
+
+//
+// P_SightSector
+// Notes that the result of the trace depends on the heights of sec.
+//
+static void P_SightSector (sector_t* sec)
+{
+    int		i;
+
+    if (numsightsectors > SIGHTSECTORS)
+	return;
+
+    for (i = 0 ; i < numsightsectors ; i++)
+	if (sightsectors[i] == sec)
+	    return;
+
+    if (numsightsectors < SIGHTSECTORS)
+	sightsectors[numsightsectors] = sec;
+
+    numsightsectors++;
+}
 
 //
 // P_DivlineSide
@@ -202,6 +253,8 @@ boolean P_CrossSubsector (int num)
 	// crosses a two sided line
 	front = seg->frontsector;
 	back = seg->backsector;
+	P_SightSector (front);
+	P_SightSector (back);
 
 	// no wall to block sight with?
 	if (front->floorheight == back->floorheight
@@ -292,13 +345,13 @@ boolean P_CrossBSPNode (int bspnum)
 
 
 //
-// P_CheckSight
+// P_TraceSight
 // Returns true
 //  if a straight line between t1 and t2 is unobstructed.
 // Uses REJECT.
 //
-boolean
-P_CheckSight
+static boolean
+P_TraceSight
 ( mobj_t*	t1,
   mobj_t*	t2 )
 {
@@ -328,6 +381,11 @@ P_CheckSight
 
     // killough 4/19/98: make fake floors and ceilings block monster view
 
+    if (s1->heightsec != -1)
+	P_SightSector (&sectors[s1->heightsec]);
+    if (s2->heightsec != -1)
+	P_SightSector (&sectors[s2->heightsec]);
+
   if ((s1->heightsec != -1 &&
        ((t1->z + t1->height <= sectors[s1->heightsec].floorheight &&
          t2->z >= sectors[s1->heightsec].floorheight) ||
@@ -362,4 +420,74 @@ P_CheckSight
     return P_CrossBSPNode (numnodes-1);	
 }
 
+//
+// P_SightMemoValid
+// True if none of the sectors the kept trace looked at has had its
+// floor or ceiling moved since.
+//
+static boolean P_SightMemoValid (const sightmemo_t* memo)
+{
+    int		i;
+
+    for (i = 0 ; i < memo->numsectors ; i++)
+	if (memo->sectors[i]->planestamp > memo->moves)
+	    return false;
+
+    return true;
+}
+
+//
+// P_CheckSight
+// Goes by the result kept for the same two things, if neither has
+// moved and no floor or ceiling along the way has since.
+//
+boolean
+P_CheckSight
+( mobj_t*	t1,
+  mobj_t*	t2 )
+{
+    sightmemo_t*	memo;
+
+    memo = &sightmemo[(((uintptr_t) t1 ^ ((uintptr_t) t2 >> 3)) >> 4)
+                      & (SIGHTMEMOSIZE - 1)];
+
+    if (memo->stamp == sightstamp
+        && memo->t1 == t1 && memo->t2 == t2
+        && memo->ss1 == t1->subsector && memo->ss2 == t2->subsector
+        && memo->x1 == t1->x && memo->y1 == t1->y
+        && memo->z1 == t1->z && memo->h1 == t1->height
+        && memo->x2 == t2->x && memo->y2 == t2->y
+        && memo->z2 == t2->z && memo->h2 == t2->height
+        && P_SightMemoValid(memo))
+    {
+	return memo->result;
+    }
+
+    numsightsectors = 0;
+    memo->result = P_TraceSight(t1, t2);
 
+    if (numsightsectors > SIGHTSECTORS)
+    {
+	memo->stamp = 0;
+	return memo->result;
+    }
+
+    memo->stamp = sightstamp;
+    memo->moves = planemoves;
+    memo->numsectors = numsightsectors;
+    memcpy(memo->sectors, sightsectors, numsightsectors * sizeof(*sightsectors));
+    memo->t1 = t1;
+    memo->t2 = t2;
+    memo->ss1 = t1->subsector;
+    memo->ss2 = t2->subsector;
+    memo->x1 = t1->x;
+    memo->y1 = t1->y;
+    memo->z1 = t1->z;
+    memo->h1 = t1->height;
+    memo->x2 = t2->x;
+    memo->y2 = t2->y;
+    memo->z2 = t2->z;
+    memo->h2 = t2->height;
+
+    return memo->result;
+}
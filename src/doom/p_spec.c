@@ -1825,26 +1825,26 @@ void P_UpdateSpecials (void)
 // [crispy] smooth texture scrolling
 void R_InterpolateTextureOffsets (void)
 {
-	// if (crispy->uncapped && leveltime > oldleveltime)
-	// {
-	// 	int i;
-
-	// 	for (i = 0; i < numlinespecials; i++)
-	// 	{
-	// 		const line_t *const line = linespeciallist[i];
-	// 		side_t *const side = &sides[line->sidenum[0]];
-
-	// 		if (line->special == 48)
-	// 		{
-	// 			side->textureoffset = side->basetextureoffset + fractionaltic;
-	// 		}
-	// 		else
-	// 		if (line->special == 85)
-	// 		{
-	// 			side->textureoffset = side->basetextureoffset - fractionaltic;
-	// 		}
-	// 	}
-	// }
+	if (uncapped && leveltime > oldleveltime)
+	{
+		int i;
+
+		for (i = 0; i < numlinespecials; i++)
+		{
+			const line_t *const line = linespeciallist[i];
+			side_t *const side = &sides[line->sidenum[0]];
+
+			if (line->special == 48)
+			{
+				side->textureoffset = side->basetextureoffset + fractionaltic;
+			}
+			else
+			if (line->special == 85)
+			{
+				side->textureoffset = side->basetextureoffset - fractionaltic;
+			}
+		}
+	}
 }
 
 //
@@ -2007,7 +2007,7 @@ int EV_DoDonut(line_t*	line)
             }
 
 	    //	Spawn rising slime
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	    floor = P_AllocateThinker (tp_floor);
 	    P_AddThinker (&floor->thinker);
 	    s2->floordata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -2021,7 +2021,7 @@ int EV_DoDonut(line_t*	line)
 	    floor->floordestheight = s3_floorheight;
 	    
 	    //	Spawn lowering donut-hole
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	    floor = P_AllocateThinker (tp_floor);
 	    P_AddThinker (&floor->thinker);
 	    s1->floordata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
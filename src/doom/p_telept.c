@@ -48,7 +48,7 @@ static mobj_t* P_TeleportDestination(line_t* line)
   int i;
   for (i = -1; (i = P_FindSectorFromLineTag(line, i)) >= 0;) {
     register thinker_t* th = NULL;
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    for (th = P_FirstClassThinker(th_mobj) ; th ; th = P_NextClassThinker(th))
       if (th->function.acp1 == (actionf_p1) P_MobjThinker) {
         register mobj_t* m = (mobj_t*)th;
         if (m->type == MT_TELEPORTMAN  &&
@@ -94,10 +94,9 @@ EV_Teleport
     {
 	if (sectors[ i ].tag == tag )
 	{
-	    thinker = thinkercap.next;
-	    for (thinker = thinkercap.next;
-		 thinker != &thinkercap;
-		 thinker = thinker->next)
+	    for (thinker = P_FirstClassThinker(th_mobj);
+		 thinker;
+		 thinker = P_NextClassThinker(thinker))
 	    {
 		// not a mobj
 		if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
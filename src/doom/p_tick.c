@@ -18,34 +18,84 @@
 //
 
 
+#include <stdio.h>
+
 #include "z_zone.h"
+#include "m_misc.h"
 #include "p_local.h"
 
 #include "doomstat.h"
 
 
 int	leveltime;
+int	oldleveltime; // [crispy] leveltime before the last tic, see R_SetupFrame()
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
+// All thinkers should be allocated by P_AllocateThinker
 // so they can be operated on uniformly.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
 //
 
+// [crispy] Each kind of thinker has a pool of fixed-size slots, cut
+// from slabs of zone memory.  Freed slots go on the free list of
+// their pool and are handed out again, the slabs are released all
+// at once with the level.
+#define SLABSLOTS	64
+
+#define SLOTSIZE(size)	(sizeof(thinkerslot_t) + (((size) + 7) & ~7))
+
+typedef struct
+{
+    const char*		name;
+    int			size;
+    int			tag;
+    thinkerslot_t*	freeslots;
+    // for the level, see P_ReleaseThinkers()
+    int			allocs;
+    int			live;
+    int			peak;
+    int			slabs;
+} slabpool_t;
+
+static slabpool_t slabpools[NUMTHINKERPOOLS] =
+{
+    {"mobj",		sizeof(mobj_t),		PU_LEVEL},
+    {"ceiling",		sizeof(ceiling_t),	PU_LEVSPEC},
+    {"door",		sizeof(vldoor_t),	PU_LEVSPEC},
+    {"floor",		sizeof(floormove_t),	PU_LEVSPEC},
+    {"plat",		sizeof(plat_t),		PU_LEVSPEC},
+    {"elevator",	sizeof(elevator_t),	PU_LEVSPEC},
+    {"fireflicker",	sizeof(fireflicker_t),	PU_LEVSPEC},
+    {"lightflash",	sizeof(lightflash_t),	PU_LEVSPEC},
+    {"strobe",		sizeof(strobe_t),	PU_LEVSPEC},
+    {"glow",		sizeof(glow_t),		PU_LEVSPEC},
+};
+
 
 
 // Both the head and tail of the thinker list.
 thinker_t	thinkercap;
 
+// [crispy] and of the list of each class
+thinkerslot_t	thinkerclasscap[NUMTHINKERCLASSES];
+
 
 //
 // P_InitThinkers
 //
 void P_InitThinkers (void)
 {
+    int		i;
+
     thinkercap.prev = thinkercap.next  = &thinkercap;
+
+    for (i = 0 ; i < NUMTHINKERCLASSES ; i++)
+    {
+	thinkerclasscap[i].cprev = thinkerclasscap[i].cnext = &thinkerclasscap[i];
+	thinkerclasscap[i].pool = -1;
+    }
 }
 
 
@@ -54,13 +104,24 @@ void P_InitThinkers (void)
 //
 // P_AddThinker
 // Adds a new thinker at the end of the list.
+// [crispy] The class goes by the pool the slot was taken from,
+// as most callers only set the function afterwards.
 //
 void P_AddThinker (thinker_t* thinker)
 {
+    thinkerslot_t*	slot = THINKERSLOT(thinker);
+    thinkerslot_t*	cap;
+
     thinkercap.prev->next = thinker;
     thinker->next = &thinkercap;
     thinker->prev = thinkercap.prev;
     thinkercap.prev = thinker;
+
+    cap = &thinkerclasscap[slot->pool == tp_mobj ? th_mobj : th_misc];
+    cap->cprev->cnext = slot;
+    slot->cnext = cap;
+    slot->cprev = cap->cprev;
+    cap->cprev = slot;
 }
 
 
@@ -80,10 +141,87 @@ void P_RemoveThinker (thinker_t* thinker)
 
 //
 // P_AllocateThinker
-// Allocates memory and adds a new thinker at the end of the list.
+// Takes a slot for a thinker from its pool, the caller
+// fills it in and adds it to the list.
+//
+void* P_AllocateThinker (thinkerpool_t pool)
+{
+    slabpool_t*		sp = &slabpools[pool];
+    thinkerslot_t*	slot;
+
+    if (!sp->freeslots)
+    {
+	const int	slotsize = SLOTSIZE(sp->size);
+	byte*		slab = Z_Malloc(SLABSLOTS * slotsize, sp->tag, NULL);
+	int		i;
+
+	for (i = SLABSLOTS-1 ; i >= 0 ; i--)
+	{
+	    slot = (thinkerslot_t *) (slab + i * slotsize);
+	    slot->pool = pool;
+	    slot->nextfree = sp->freeslots;
+	    sp->freeslots = slot;
+	}
+
+	sp->slabs++;
+    }
+
+    slot = sp->freeslots;
+    sp->freeslots = slot->nextfree;
+
+    sp->allocs++;
+    if (++sp->live > sp->peak)
+	sp->peak = sp->live;
+
+    return slot + 1;
+}
+
+
+
+//
+// P_FreeThinker
+// Puts the slot of a thinker back on the free list of its pool.
 //
-void P_AllocateThinker (thinker_t*	thinker)
+void P_FreeThinker (thinker_t* thinker)
 {
+    thinkerslot_t*	slot = THINKERSLOT(thinker);
+    slabpool_t*		sp = &slabpools[slot->pool];
+
+    slot->nextfree = sp->freeslots;
+    sp->freeslots = slot;
+    sp->live--;
+}
+
+
+
+//
+// P_ReleaseThinkers
+// Called before the zone memory of the level is freed, which takes
+// the slabs along.  Reports what the pools were used for.
+//
+void P_ReleaseThinkers (void)
+{
+    char	report[512] = "";
+    int		i;
+
+    for (i = 0 ; i < NUMTHINKERPOOLS ; i++)
+    {
+	slabpool_t*	sp = &slabpools[i];
+	char		entry[64];
+
+	if (sp->allocs)
+	{
+	    M_snprintf(entry, sizeof(entry), " %s %d/%d/%d",
+	               sp->name, sp->allocs, sp->peak, sp->slabs);
+	    M_StringConcat(report, entry, sizeof(report));
+	}
+
+	sp->freeslots = NULL;
+	sp->allocs = sp->live = sp->peak = sp->slabs = 0;
+    }
+
+    if (report[0])
+	fprintf(stderr, "P_ReleaseThinkers: allocations/peak/slabs:%s\n", report);
 }
 
 
@@ -94,6 +232,7 @@ void P_AllocateThinker (thinker_t*	thinker)
 void P_RunThinkers (void)
 {
     thinker_t *currentthinker, *nextthinker;
+    thinkerslot_t *slot;
 
     currentthinker = thinkercap.next;
     while (currentthinker != &thinkercap)
@@ -104,7 +243,10 @@ void P_RunThinkers (void)
             nextthinker = currentthinker->next;
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
-	    Z_Free(currentthinker);
+	    slot = THINKERSLOT(currentthinker);
+	    slot->cnext->cprev = slot->cprev;
+	    slot->cprev->cnext = slot->cnext;
+	    P_FreeThinker(currentthinker);
 	}
 	else
 	{
@@ -125,6 +267,8 @@ void P_RunThinkers (void)
 void P_Ticker (void)
 {
     int		i;
+
+    oldleveltime = leveltime;
     
     // run the tic
     if (paused)
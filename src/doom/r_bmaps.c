@@ -19,8 +19,11 @@
 //	Adapted from doomretro/src/r_data.c:97-209
 //
 
+#include <stdlib.h>
+
 #include "doomtype.h"
 #include "doomstat.h"
+#include "i_system.h"
 #include "r_data.h"
 #include "w_wad.h"
 
@@ -294,7 +297,7 @@ static byte chexredgreen[256] =
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 };
 
-byte *dc_brightmap = nobrightmap;
+THREADLOCAL byte *dc_brightmap = nobrightmap;
 
 // [crispy] brightmaps for textures
 
@@ -698,3 +701,103 @@ void R_InitBrightmaps (int flats)
 		}
 	}
 }
+
+// [crispy] fused colormaps
+// The column and span drawers resolve every texel through the
+// brightmap, the light level colormap and the sector colormap.  These
+// three lookups are folded into one 256-entry table per combination,
+// built on first use and kept across frames.  Each render thread has
+// its own cache, so no locking is needed.
+
+#define FUSEDHASH 256
+#define MAXFUSEDMAPS 1024
+
+typedef struct fusedmap_s
+{
+	struct fusedmap_s *next;
+	const lighttable_t *colormap[2];
+	const byte *brightmap;
+	const lighttable_t *final;
+	lighttable_t map[256];
+} fusedmap_t;
+
+static THREADLOCAL fusedmap_t *fusedmaps[FUSEDHASH];
+static THREADLOCAL fusedmap_t *lastfused;
+static THREADLOCAL int numfusedmaps;
+
+static void R_FlushFusedColormaps (void)
+{
+	int i;
+
+	for (i = 0; i < FUSEDHASH; i++)
+	{
+		while (fusedmaps[i])
+		{
+			fusedmap_t *const next = fusedmaps[i]->next;
+			free(fusedmaps[i]);
+			fusedmaps[i] = next;
+		}
+	}
+
+	lastfused = NULL;
+	numfusedmaps = 0;
+}
+
+// Returns the table for final[colormap[brightmap[c]][c]], or for
+// colormap[brightmap[c]][c] if final is NULL.
+
+const lighttable_t *R_FusedColormap (lighttable_t *const colormap[2],
+                                     const byte *brightmap,
+                                     const lighttable_t *final)
+{
+	fusedmap_t *fused = lastfused;
+	unsigned int hash;
+	int i;
+
+	if (fused && fused->colormap[0] == colormap[0] &&
+	    fused->colormap[1] == colormap[1] &&
+	    fused->brightmap == brightmap && fused->final == final)
+	{
+		return fused->map;
+	}
+
+	// colormaps are 256 bytes apart, so drop the low bits
+	hash = ((uintptr_t) colormap[0] >> 8) + ((uintptr_t) colormap[1] >> 6) +
+	       ((uintptr_t) brightmap >> 8) + ((uintptr_t) final >> 8);
+	hash &= FUSEDHASH - 1;
+
+	for (fused = fusedmaps[hash]; fused; fused = fused->next)
+	{
+		if (fused->colormap[0] == colormap[0] &&
+		    fused->colormap[1] == colormap[1] &&
+		    fused->brightmap == brightmap && fused->final == final)
+		{
+			lastfused = fused;
+			return fused->map;
+		}
+	}
+
+	if (numfusedmaps == MAXFUSEDMAPS)
+	{
+		R_FlushFusedColormaps();
+	}
+
+	fused = I_Realloc(NULL, sizeof(*fused));
+	fused->colormap[0] = colormap[0];
+	fused->colormap[1] = colormap[1];
+	fused->brightmap = brightmap;
+	fused->final = final;
+
+	for (i = 0; i < 256; i++)
+	{
+		const lighttable_t c = colormap[brightmap[i]][i];
+		fused->map[i] = final ? final[c] : c;
+	}
+
+	fused->next = fusedmaps[hash];
+	fusedmaps[hash] = fused;
+	numfusedmaps++;
+
+	lastfused = fused;
+	return fused->map;
+}
@@ -21,6 +21,7 @@
 #define __R_BMAPS__
 
 #include "doomtype.h"
+#include "r_defs.h"
 
 extern void R_InitBrightmaps (int flats);
 
@@ -31,4 +32,8 @@ extern byte *(*R_BrightmapForState) (const int state);
 
 extern byte **texturebrightmap;
 
+extern const lighttable_t *R_FusedColormap (lighttable_t *const colormap[2],
+                                            const byte *brightmap,
+                                            const lighttable_t *final);
+
 #endif
@@ -28,6 +28,7 @@
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_things.h"
+#include "r_pvs.h"
 
 // State.
 #include "doomstat.h"
@@ -36,15 +37,15 @@
 
 
 
-seg_t*		curline;
-side_t*		sidedef;
-line_t*		linedef;
-sector_t*	frontsector;
-sector_t*	backsector;
+THREADLOCAL seg_t*		curline;
+THREADLOCAL side_t*		sidedef;
+THREADLOCAL line_t*		linedef;
+THREADLOCAL sector_t*	frontsector;
+THREADLOCAL sector_t*	backsector;
 
-drawseg_t*	drawsegs = NULL;
-drawseg_t*	ds_p;
-int		numdrawsegs = 0;
+THREADLOCAL drawseg_t*	drawsegs = NULL;
+THREADLOCAL drawseg_t*	ds_p;
+THREADLOCAL int		numdrawsegs = 0;
 
 
 void
@@ -87,8 +88,78 @@ typedef	struct
 #define MAXSEGS (MAXWIDTH / 2 + 1)
 
 // newend is one past the last valid seg
-cliprange_t*	newend;
-cliprange_t	solidsegs[MAXSEGS];
+THREADLOCAL cliprange_t*	newend;
+THREADLOCAL cliprange_t	solidsegs[MAXSEGS];
+
+// [crispy] The columns covered by solidsegs, one bit per column, so that
+// R_CheckBBox() can test a range a word at a time instead of walking
+// the clip list.  Once the solidsegs have merged into one, the whole
+// view is covered and R_RenderBSPNode() stops.
+typedef uint64_t solidword_t;
+#define SOLIDBITS	64
+#define SOLIDWORDS	((MAXWIDTH + SOLIDBITS - 1) / SOLIDBITS)
+
+static THREADLOCAL solidword_t	solidcols[SOLIDWORDS];
+
+static inline void
+R_SolidMasks
+( int		first,
+  int		last,
+  solidword_t*	m1,
+  solidword_t*	m2 )
+{
+    *m1 = ~(solidword_t) 0 << (first % SOLIDBITS);
+    *m2 = ~(solidword_t) 0 >> (SOLIDBITS - 1 - last % SOLIDBITS);
+}
+
+static void R_MarkSolidColumns (int first, int last)
+{
+    solidword_t	m1, m2;
+    int		w, w1, w2;
+
+    first = MAX(first, 0);
+    last = MIN(last, viewwidth - 1);
+
+    if (first > last)
+	return;
+
+    R_SolidMasks(first, last, &m1, &m2);
+    w1 = first / SOLIDBITS;
+    w2 = last / SOLIDBITS;
+
+    if (w1 == w2)
+    {
+	solidcols[w1] |= m1 & m2;
+	return;
+    }
+
+    solidcols[w1] |= m1;
+    for (w = w1 + 1; w < w2; w++)
+	solidcols[w] = ~(solidword_t) 0;
+    solidcols[w2] |= m2;
+}
+
+static boolean R_SolidColumns (int first, int last)
+{
+    solidword_t	m1, m2;
+    int		w, w1, w2;
+
+    R_SolidMasks(first, last, &m1, &m2);
+    w1 = first / SOLIDBITS;
+    w2 = last / SOLIDBITS;
+
+    if (w1 == w2)
+	return (solidcols[w1] & (m1 & m2)) == (m1 & m2);
+
+    if ((solidcols[w1] & m1) != m1 || (solidcols[w2] & m2) != m2)
+	return false;
+
+    for (w = w1 + 1; w < w2; w++)
+	if (~solidcols[w])
+	    return false;
+
+    return true;
+}
 
 
 
@@ -107,6 +178,9 @@ R_ClipSolidWallSegment
     cliprange_t*	next;
     cliprange_t*	start;
 
+    // [crispy] whatever path is taken below, the range ends up solid
+    R_MarkSolidColumns (first, last);
+
     // Find the first range that touches the range
     //  (adjacent pixels are touching).
     start = solidsegs;
@@ -248,13 +322,34 @@ void R_ClearClipSegs (void)
     solidsegs[1].first = viewwidth;
     solidsegs[1].last = 0x7fffffff;
     newend = solidsegs+2;
+
+    memset(solidcols, 0, sizeof(solidcols));
 }
 
 // [AM] Interpolate the passed sector, if prudent.
+// Only writes on change, since strip rendering threads share the sectors.
 void R_MaybeInterpolateSector(sector_t* sector)
 {
-    sector->interpfloorheight = sector->floorheight;
-    sector->interpceilingheight = sector->ceilingheight;
+    fixed_t floorheight = sector->floorheight;
+    fixed_t ceilingheight = sector->ceilingheight;
+
+    if (uncapped &&
+        // Only if we moved the sector last tic.
+        sector->oldgametic == gametic - 1)
+    {
+        // Interpolate between current and last floor/ceiling position.
+        if (floorheight != sector->oldfloorheight)
+            floorheight = sector->oldfloorheight +
+                FixedMul(floorheight - sector->oldfloorheight, fractionaltic);
+        if (ceilingheight != sector->oldceilingheight)
+            ceilingheight = sector->oldceilingheight +
+                FixedMul(ceilingheight - sector->oldceilingheight, fractionaltic);
+    }
+
+    if (sector->interpfloorheight != floorheight)
+	sector->interpfloorheight = floorheight;
+    if (sector->interpceilingheight != ceilingheight)
+	sector->interpceilingheight = ceilingheight;
 }
 
 //
@@ -514,8 +609,6 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
     angle_t		angle2;
     angle_t		span;
     angle_t		tspan;
-    
-    cliprange_t*	start;
 
     int			sx1;
     int			sx2;
@@ -593,14 +686,11 @@ boolean R_CheckBBox (fixed_t*	bspcoord)
 	return false;			
     sx2--;
 	
-    start = solidsegs;
-    while (start->last < sx2)
-	start++;
-    
-    if (sx1 >= start->first
-	&& sx2 <= start->last)
+    // [crispy] The clipposts never touch, so one of them contains
+    // the span exactly if all of its columns are solid.
+    if (R_SolidColumns(MAX(sx1, 0), MIN(sx2, viewwidth - 1)))
     {
-	// The clippost contains the new span.
+	rstats.culled++;
 	return false;
     }
 
@@ -721,17 +811,33 @@ void R_RenderBSPNode (int bspnum)
     node_t*	bsp;
     int		side;
 
+    // [crispy] nothing can show behind a fully covered view
+    if (newend == solidsegs+1)
+    {
+	rstats.earlyouts++;
+	return;
+    }
+
     // Found a subsector?
     if (bspnum & NF_SUBSECTOR)
     {
 	if (bspnum == -1)			
-	    R_Subsector (0);
+	    bspnum = 0;
 	else
-	    R_Subsector (bspnum&(~NF_SUBSECTOR));
+	    bspnum &= ~NF_SUBSECTOR;
+
+	// [crispy] out of sight of the view sector
+	if (!pvssubsectors || pvssubsectors[bspnum])
+	    R_Subsector (bspnum);
 	return;
     }
+
+    // [crispy] nothing in the subtree is in sight of the view sector
+    if (pvsnodes && !pvsnodes[bspnum])
+	return;
 		
     bsp = &nodes[bspnum];
+    rstats.nodes++;
     
     // Decide which side the view point is on.
     side = R_PointOnSide (viewx, viewy, bsp);
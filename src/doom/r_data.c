@@ -18,10 +18,12 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "deh_main.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_thread.h"
 #include "z_zone.h"
 
 
@@ -246,6 +248,15 @@ R_DrawColumnInCache
 }
 
 
+// [crispy] Lumps and composites the render threads draw from once the
+// cache is unlocked again are kept PU_STATIC until the frame is done,
+// or another thread could purge them meanwhile, see R_ReleaseFrameCache().
+// Whoever caches a lump with the cache locked must not make it purgable
+// while it is kept.
+static boolean		*framelumps;
+static boolean		*framecomposites;
+
+#define FRAMECACHETAG(lump)	(framelumps[lump] ? PU_STATIC : PU_CACHE)
 
 //
 // R_GenerateComposite
@@ -273,9 +284,11 @@ void R_GenerateComposite (int texnum)
 	
     texture = textures[texnum];
 
+    // Only publish the composite once it is complete, other render
+    // threads test texturecomposite[] without holding the cache lock.
     block = Z_Malloc (texturecompositesize[texnum],
 		      PU_STATIC, 
-		      &texturecomposite[texnum]);	
+		      NULL);
 
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
@@ -293,7 +306,7 @@ void R_GenerateComposite (int texnum)
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+	realpatch = W_CacheLumpNum (patch->patch, FRAMECACHETAG(patch->patch));
 	x1 = patch->originx;
 	x2 = x1 + SHORT(realpatch->width);
 
@@ -368,6 +381,8 @@ void R_GenerateComposite (int texnum)
     free(source); // free temporary column
     free(marks); // free transparency marks
 
+    Z_ChangeUser (block, (void **) &texturecomposite[texnum]);
+
     // Now that the texture has been built in column cache,
     //  it is purgable from zone memory.
     Z_ChangeTag (block, PU_CACHE);
@@ -539,6 +554,73 @@ void R_GenerateLookup (int texnum)
 
 
 
+// [crispy] level texture arena, see R_BuildArena()
+typedef struct
+{
+    byte	*opaque;
+    byte	*masked;
+} arenacolumn_t;
+
+static arenacolumn_t	**arenacolumns;
+byte			**arenaflats;
+patch_t			**arenasprites;
+
+// [crispy] the zone blocks kept for the frame, see R_CacheLumpForFrame()
+static void		**frameblocks;
+static int		numframeblocks;
+static int		maxframeblocks;
+
+static void R_KeepBlockForFrame (void *block)
+{
+    Z_ChangeTag(block, PU_STATIC);
+
+    if (numframeblocks == maxframeblocks)
+    {
+	maxframeblocks = maxframeblocks ? 2 * maxframeblocks : 128;
+	frameblocks = I_Realloc(frameblocks, maxframeblocks * sizeof(*frameblocks));
+    }
+
+    frameblocks[numframeblocks++] = block;
+}
+
+//
+// R_CacheLumpForFrame
+// [crispy] W_CacheLumpNum() for the render threads, with the cache
+//  locked.  The lump stays where it is until R_ReleaseFrameCache().
+//
+void *R_CacheLumpForFrame (int lump)
+{
+    void *data = W_CacheLumpNum(lump, PU_STATIC);
+
+    // lumps of memory-mapped WADs are not in the zone
+    if (!framelumps[lump] && lumpinfo[lump]->cache)
+    {
+	framelumps[lump] = true;
+	R_KeepBlockForFrame(lumpinfo[lump]->cache);
+    }
+
+    return data;
+}
+
+//
+// R_ReleaseFrameCache
+// [crispy] Called once all render threads are done with the frame.
+//
+void R_ReleaseFrameCache (void)
+{
+    int i;
+
+    if (!numframeblocks)
+	return;
+
+    for (i = 0; i < numframeblocks; i++)
+	Z_ChangeTag(frameblocks[i], PU_CACHE);
+
+    numframeblocks = 0;
+    memset(framelumps, 0, numlumps * sizeof(*framelumps));
+    memset(framecomposites, 0, numtextures * sizeof(*framecomposites));
+}
+
 //
 // R_GetColumn
 //
@@ -553,21 +635,290 @@ R_GetColumn
     int		ofs2;
 	
     col &= texturewidthmask[tex];
+
+    // [crispy] textures of the current level are read from the arena
+    if (arenacolumns && arenacolumns[tex])
+    {
+	return opaque ? arenacolumns[tex][col].opaque : arenacolumns[tex][col].masked;
+    }
+
     lump = texturecolumnlump[tex][col];
     ofs = texturecolumnofs[tex][col];
     ofs2 = texturecolumnofs2[tex][col];
     
     // [crispy] single-patched mid-textures on two-sided walls
     if (lump > 0 && !opaque)
-	return (byte *)W_CacheLumpNum(lump,PU_CACHE)+ofs2;
+    {
+	byte *patch;
+
+	I_LockCache();
+	patch = R_CacheLumpForFrame(lump);
+	I_UnlockCache();
+
+	return patch+ofs2;
+    }
 
-    if (!texturecomposite[tex])
-	R_GenerateComposite (tex);
+    if (!framecomposites[tex])
+    {
+	I_LockCache();
+	// another render thread may have built it in the meantime
+	if (!texturecomposite[tex])
+	    R_GenerateComposite (tex);
+	if (!framecomposites[tex])
+	{
+	    R_KeepBlockForFrame(texturecomposite[tex]);
+	    framecomposites[tex] = true;
+	}
+	I_UnlockCache();
+    }
 
     return texturecomposite[tex] + ofs;
 }
 
 
+//
+// [crispy] Texture and flat LOD levels.
+// Level n is the texture shrunk by 2^n in both directions, each texel
+//  being the texel of its 2^n*2^n block that is closest to the average
+//  color of the block.  Distant walls and flats are drawn from these,
+//  so that stepping through them skips less memory.  The levels are
+//  built by R_PrecacheLevel() or on first use, and freed with the level.
+//
+
+int			render_lod = 0;
+
+static byte*		(*texturelod)[MAXLOD];
+static byte*		texturemaxlod;
+static byte*		(*flatlod)[MAXLOD];
+static byte		lodpalette[256 * 3];
+
+static void R_InitLOD (void)
+{
+    const byte *playpal;
+    int i, lod;
+
+    texturelod = Z_Malloc(numtextures * sizeof(*texturelod), PU_STATIC, 0);
+    memset(texturelod, 0, numtextures * sizeof(*texturelod));
+    texturemaxlod = Z_Malloc(numtextures * sizeof(*texturemaxlod), PU_STATIC, 0);
+
+    // only textures that wrap around at a power of two width
+    // and that divide evenly in height get the levels
+    for (i = 0; i < numtextures; i++)
+    {
+	const int height = textureheight[i] >> FRACBITS;
+
+	lod = 0;
+
+	if (textures[i]->width == texturewidthmask[i] + 1)
+	{
+	    while (lod < MAXLOD && (textures[i]->width >> (lod + 1)) &&
+	           (height >> (lod + 1)) && !(height & ((2 << lod) - 1)))
+	    {
+		lod++;
+	    }
+	}
+
+	texturemaxlod[i] = lod;
+    }
+
+    flatlod = Z_Malloc(numflats * sizeof(*flatlod), PU_STATIC, 0);
+    memset(flatlod, 0, numflats * sizeof(*flatlod));
+
+    playpal = W_CacheLumpName(DEH_String("PLAYPAL"), PU_STATIC);
+    memcpy(lodpalette, playpal, sizeof(lodpalette));
+    W_ReleaseLumpName(DEH_String("PLAYPAL"));
+}
+
+//
+// R_BlockTexel
+// Returns the texel of an n*n block closest to its average color.
+//  The columns of the block start at cols[], their texels are
+//  rowstride bytes apart.
+//
+static byte R_BlockTexel (const byte *const *cols, int rowstride, int n)
+{
+    int r = 0, g = 0, b = 0;
+    int best = 0, bestdist = INT_MAX;
+    int i, j;
+
+    for (i = 0; i < n; i++)
+    {
+	for (j = 0; j < n; j++)
+	{
+	    const byte *const rgb = &lodpalette[3 * cols[i][j * rowstride]];
+
+	    r += rgb[0];
+	    g += rgb[1];
+	    b += rgb[2];
+	}
+    }
+
+    r /= n * n;
+    g /= n * n;
+    b /= n * n;
+
+    for (i = 0; i < n; i++)
+    {
+	for (j = 0; j < n; j++)
+	{
+	    const byte c = cols[i][j * rowstride];
+	    const byte *const rgb = &lodpalette[3 * c];
+	    const int dist = (rgb[0] - r) * (rgb[0] - r)
+	                   + (rgb[1] - g) * (rgb[1] - g)
+	                   + (rgb[2] - b) * (rgb[2] - b);
+
+	    if (dist < bestdist)
+	    {
+		best = c;
+		bestdist = dist;
+	    }
+	}
+    }
+
+    return best;
+}
+
+//
+// R_GenerateTextureLOD
+// Level lod of a texture, stored column after column.
+//
+static void R_GenerateTextureLOD (int tex, int lod)
+{
+    const int n = 1 << lod;
+    const int width = textures[tex]->width >> lod;
+    const int height = (textureheight[tex] >> FRACBITS) >> lod;
+    const byte *cols[1 << MAXLOD];
+    const byte *block[1 << MAXLOD];
+    byte *lodblock, *dest;
+    int x, y, i;
+
+    lodblock = Z_Malloc(width * height, PU_LEVEL, NULL);
+    dest = lodblock;
+
+    for (x = 0; x < width; x++)
+    {
+	for (i = 0; i < n; i++)
+	    cols[i] = R_GetColumn(tex, (x << lod) + i, true);
+
+	for (y = 0; y < height; y++)
+	{
+	    for (i = 0; i < n; i++)
+		block[i] = cols[i] + (y << lod);
+
+	    *dest++ = R_BlockTexel(block, 1, n);
+	}
+    }
+
+    // publish it complete, see R_GenerateComposite()
+    Z_ChangeUser(lodblock, (void **) &texturelod[tex][lod - 1]);
+}
+
+//
+// R_GenerateFlatLOD
+// Level lod of a flat, stored row after row like the flat.
+//
+static void R_GenerateFlatLOD (int flat, int lod)
+{
+    const int n = 1 << lod;
+    const int size = 64 >> lod;
+    const byte *cols[1 << MAXLOD];
+    const byte *source;
+    byte *lodblock, *dest;
+    int x, y, i;
+
+    lodblock = Z_Malloc(size * size, PU_LEVEL, NULL);
+    dest = lodblock;
+
+    source = R_CacheLumpForFrame(firstflat + flat);
+
+    for (y = 0; y < size; y++)
+    {
+	for (x = 0; x < size; x++)
+	{
+	    for (i = 0; i < n; i++)
+		cols[i] = source + ((y << lod) << 6) + (x << lod) + i;
+
+	    *dest++ = R_BlockTexel(cols, 64, n);
+	}
+    }
+
+    Z_ChangeUser(lodblock, (void **) &flatlod[flat][lod - 1]);
+}
+
+//
+// R_TextureLOD
+// Returns the LOD level to draw a texture with when its texels are
+//  iscale apart on screen, 0 for the texture itself.
+//
+int R_TextureLOD (int tex, fixed_t iscale)
+{
+    int lod = 0;
+
+    if (!render_lod)
+	return 0;
+
+    while (lod < texturemaxlod[tex] && (unsigned) iscale >= (2u << FRACBITS) << lod)
+	lod++;
+
+    return lod;
+}
+
+//
+// R_GetColumnLOD
+// R_GetColumn() for LOD level lod > 0 of a texture.
+//
+byte *R_GetColumnLOD (int tex, int lod, int col)
+{
+    const int height = (textureheight[tex] >> FRACBITS) >> lod;
+
+    if (!texturelod[tex][lod - 1])
+    {
+	I_LockCache();
+	// another render thread may have built it in the meantime
+	if (!texturelod[tex][lod - 1])
+	    R_GenerateTextureLOD(tex, lod);
+	I_UnlockCache();
+    }
+
+    return texturelod[tex][lod - 1] + ((col & texturewidthmask[tex]) >> lod) * height;
+}
+
+//
+// R_FlatLOD
+// Returns the LOD level to draw a flat with when its texels are
+//  step apart on screen, 0 for the flat itself.
+//
+int R_FlatLOD (fixed_t step)
+{
+    int lod = 0;
+
+    if (!render_lod)
+	return 0;
+
+    while (lod < MAXLOD && (unsigned) step >= (2u << FRACBITS) << lod)
+	lod++;
+
+    return lod;
+}
+
+//
+// R_GetFlatLOD
+// LOD level lod > 0 of a flat, (64 >> lod) texels square.
+//
+byte *R_GetFlatLOD (int flat, int lod)
+{
+    if (!flatlod[flat][lod - 1])
+    {
+	I_LockCache();
+	if (!flatlod[flat][lod - 1])
+	    R_GenerateFlatLOD(flat, lod);
+	I_UnlockCache();
+    }
+
+    return flatlod[flat][lod - 1];
+}
+
+
 static void GenerateTextureHashTable(void)
 {
     texture_t **rover;
@@ -1139,6 +1490,12 @@ void R_InitData (void)
     R_InitSpriteLumps ();
     R_InitColormaps ();
     R_InitTranMap(); // [crispy] prints a mark itself
+    R_InitLOD ();
+
+    framelumps = Z_Malloc(numlumps * sizeof(*framelumps), PU_STATIC, 0);
+    memset(framelumps, 0, numlumps * sizeof(*framelumps));
+    framecomposites = Z_Malloc(numtextures * sizeof(*framecomposites), PU_STATIC, 0);
+    memset(framecomposites, 0, numtextures * sizeof(*framecomposites));
 }
 
 
@@ -1232,6 +1589,221 @@ int R_TextureNumForName(const char *name)
 //
 // R_PrecacheLevel
 // Preloads all relevant graphics for the level.
+//
+// [crispy] R_BuildArena
+// Packs the columns of all textures, flats and sprite lumps the level
+//  uses into one contiguous, cache line aligned block with a column
+//  pointer table per texture, so that R_GetColumn() no longer goes
+//  through the zone and the WAD cache for them.  Single-patched columns
+//  point into one shared copy of their patch, only multi-patched columns
+//  and single-patched columns with holes are copied from the composite.
+//  The arena is rebuilt for every level, anything that is not in it is
+//  looked up as before.
+//
+
+#define ARENAALIGN	64
+
+static byte		*arenablock;
+static byte		*arena;
+static int		arenaused;
+static int		*arenalumps; // arena offset of each lump, or -1
+
+// Returns NULL while the arena is only being measured.
+static byte *R_ArenaAlloc (int size)
+{
+    byte *block = arena ? arena + arenaused : NULL;
+
+    arenaused += (size + ARENAALIGN - 1) & ~(ARENAALIGN - 1);
+
+    return block;
+}
+
+static byte *R_ArenaLump (int lump)
+{
+    if (arenalumps[lump] < 0)
+    {
+	const int size = W_LumpLength(lump);
+	byte *block;
+
+	arenalumps[lump] = arenaused;
+	block = R_ArenaAlloc(size);
+
+	if (block)
+	    memcpy(block, W_CacheLumpNum(lump, PU_CACHE), size);
+    }
+
+    return arena ? arena + arenalumps[lump] : NULL;
+}
+
+// A single-patched column is composited without its originy, so where
+//  the patch column is one post covering the texture height its pixels
+//  are those of the composite column.
+static boolean R_SolidPatchColumn (int tex, int col)
+{
+    const byte *patch = W_CacheLumpNum(texturecolumnlump[tex][col], PU_CACHE);
+    const column_t *column = (const column_t *) (patch + texturecolumnofs2[tex][col] - 3);
+
+    return column->topdelta == 0 && column->length >= textures[tex]->height;
+}
+
+static int R_CompositeColumnSize (int tex, int col)
+{
+    const int next = (col + 1 < textures[tex]->width) ?
+                     texturecolumnofs[tex][col + 1] :
+                     texturecompositesize[tex] + 3;
+
+    return next - texturecolumnofs[tex][col];
+}
+
+static void R_ArenaTexture (int tex)
+{
+    const texture_t *texture = textures[tex];
+    const short *collump = texturecolumnlump[tex];
+    arenacolumn_t *columns;
+    byte *composite = NULL;
+    byte *block;
+    int size = 0;
+    int x;
+
+    columns = (arenacolumn_t *) R_ArenaAlloc(texture->width * sizeof(*columns));
+
+    for (x = 0; x < texture->width; x++)
+    {
+	if (collump[x] > 0)
+	    R_ArenaLump(collump[x]);
+
+	if (collump[x] <= 0 || !R_SolidPatchColumn(tex, x))
+	    size += R_CompositeColumnSize(tex, x);
+    }
+
+    block = R_ArenaAlloc(size);
+
+    if (!columns)
+	return;
+
+    if (size)
+    {
+	if (!texturecomposite[tex])
+	    R_GenerateComposite(tex);
+
+	// keep it while the patches are cached below
+	composite = texturecomposite[tex];
+	Z_ChangeTag(composite, PU_STATIC);
+    }
+
+    for (x = 0; x < texture->width; x++)
+    {
+	byte *column = NULL;
+
+	if (collump[x] <= 0 || !R_SolidPatchColumn(tex, x))
+	{
+	    const int colsize = R_CompositeColumnSize(tex, x);
+
+	    memcpy(block, composite + texturecolumnofs[tex][x] - 3, colsize);
+	    column = block + 3;
+	    block += colsize;
+	}
+
+	if (collump[x] > 0)
+	{
+	    columns[x].masked = R_ArenaLump(collump[x]) + texturecolumnofs2[tex][x];
+	    columns[x].opaque = column ? column : columns[x].masked;
+	}
+	else
+	{
+	    columns[x].opaque = columns[x].masked = column;
+	}
+    }
+
+    if (composite)
+	Z_ChangeTag(composite, PU_CACHE);
+
+    arenacolumns[tex] = columns;
+}
+
+static void R_ArenaPass (const char *flatpresent, const char *texturepresent,
+                         const char *spritepresent)
+{
+    int i, j, k;
+
+    arenaused = 0;
+    memset(arenalumps, 0xff, numlumps * sizeof(*arenalumps));
+
+    for (i = 0; i < numtextures; i++)
+    {
+	if (texturepresent[i])
+	    R_ArenaTexture(i);
+    }
+
+    for (i = 0; i < numflats; i++)
+    {
+	if (flatpresent[i])
+	    arenaflats[i] = R_ArenaLump(firstflat + i);
+    }
+
+    for (i = 0; i < numsprites; i++)
+    {
+	if (!spritepresent[i])
+	    continue;
+
+	for (j = 0; j < sprites[i].numframes; j++)
+	{
+	    const spriteframe_t *sf = &sprites[i].spriteframes[j];
+	    const int rotations = sf->rotate == 2 ? 16 : 8;
+
+	    // frames without any patches are left with lump[] at -1
+	    if (sf->rotate == -1)
+		continue;
+
+	    for (k = 0; k < rotations; k++)
+	    {
+		if (sf->lump[k] < 0)
+		    continue;
+
+		arenasprites[sf->lump[k]] = (patch_t *) R_ArenaLump(firstspritelump + sf->lump[k]);
+	    }
+	}
+    }
+}
+
+static void R_BuildArena (const char *flatpresent, const char *texturepresent,
+                          const char *spritepresent)
+{
+    if (!arenacolumns)
+    {
+	arenacolumns = Z_Malloc(numtextures * sizeof(*arenacolumns), PU_STATIC, NULL);
+	arenaflats = Z_Malloc(numflats * sizeof(*arenaflats), PU_STATIC, NULL);
+	arenasprites = Z_Malloc(numspritelumps * sizeof(*arenasprites), PU_STATIC, NULL);
+    }
+
+    // drop the previous level's arena
+    memset(arenacolumns, 0, numtextures * sizeof(*arenacolumns));
+    memset(arenaflats, 0, numflats * sizeof(*arenaflats));
+    memset(arenasprites, 0, numspritelumps * sizeof(*arenasprites));
+    free(arenablock);
+    arenablock = arena = NULL;
+
+    arenalumps = Z_Malloc(numlumps * sizeof(*arenalumps), PU_STATIC, NULL);
+
+    // measure, then fill
+    R_ArenaPass(flatpresent, texturepresent, spritepresent);
+
+    arenablock = malloc(arenaused + ARENAALIGN - 1);
+
+    if (arenablock)
+    {
+	arena = (byte *) (((uintptr_t) arenablock + ARENAALIGN - 1) & ~(uintptr_t) (ARENAALIGN - 1));
+	R_ArenaPass(flatpresent, texturepresent, spritepresent);
+    }
+    else
+    {
+	fprintf(stderr, "R_BuildArena: failed to allocate %d KB texture arena\n",
+	        arenaused >> 10);
+    }
+
+    Z_Free(arenalumps);
+}
+
 //
 int		flatmemory;
 int		texturememory;
@@ -1274,11 +1846,14 @@ void R_PrecacheLevel (void)
 	    lump = firstflat + i;
 	    flatmemory += lumpinfo[lump]->size;
 	    W_CacheLumpNum(lump, PU_CACHE);
+
+	    // [crispy] texture and flat LOD
+	    if (render_lod)
+		for (j = 1 ; j <= MAXLOD ; j++)
+		    R_GetFlatLOD(i, j);
 	}
     }
 
-    Z_Free(flatpresent);
-    
     // Precache textures.
     texturepresent = Z_Malloc(numtextures, PU_STATIC, NULL);
     memset (texturepresent,0, numtextures);
@@ -1307,6 +1882,11 @@ void R_PrecacheLevel (void)
 	// [crispy] precache composite textures
 	R_GenerateComposite(i);
 
+	// [crispy] texture and flat LOD
+	if (render_lod)
+	    for (j = 1 ; j <= texturemaxlod[i] ; j++)
+		R_GetColumnLOD(i, j, 0);
+
 	texture = textures[i];
 	
 	for (j=0 ; j<texture->patchcount ; j++)
@@ -1317,13 +1897,11 @@ void R_PrecacheLevel (void)
 	}
     }
 
-    Z_Free(texturepresent);
-    
     // Precache sprites.
     spritepresent = Z_Malloc(numsprites, PU_STATIC, NULL);
     memset (spritepresent,0, numsprites);
 	
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    for (th = P_FirstClassThinker(th_mobj) ; th ; th = P_NextClassThinker(th))
     {
 	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 	    spritepresent[((mobj_t *)th)->sprite] = 1;
@@ -1347,6 +1925,11 @@ void R_PrecacheLevel (void)
 	}
     }
 
+    // [crispy] pack it all into the level texture arena
+    R_BuildArena(flatpresent, texturepresent, spritepresent);
+
+    Z_Free(flatpresent);
+    Z_Free(texturepresent);
     Z_Free(spritepresent);
 }
 
@@ -36,6 +36,24 @@ R_GetColumn
   boolean	opaque );
 
 
+// [crispy] texture and flat LOD
+#define MAXLOD		3
+
+extern int render_lod;
+
+int R_TextureLOD (int tex, fixed_t iscale);
+byte *R_GetColumnLOD (int tex, int lod, int col);
+int R_FlatLOD (fixed_t step);
+byte *R_GetFlatLOD (int flat, int lod);
+
+// [crispy] lumps cached by the render threads, see R_ReleaseFrameCache()
+void *R_CacheLumpForFrame (int lump);
+void R_ReleaseFrameCache (void);
+
+// [crispy] level texture arena, NULL where not packed
+extern byte **arenaflats;
+extern patch_t **arenasprites;
+
 // I/O, setting up the stuff.
 void R_InitData (void);
 void R_PrecacheLevel (void);
@@ -183,6 +183,10 @@ typedef	struct
 
     // killough 4/11/98: support for lightlevels coming from another sector
     int floorlightsec, ceilinglightsec;
+
+    // [crispy] planemoves when the floor or ceiling last moved,
+    //  see P_CheckSight()
+    int		planestamp;
 } sector_t;
 
 
@@ -501,25 +505,20 @@ typedef struct
 //
 // Now what is a visplane, anyway?
 // 
-typedef struct
+typedef struct visplane_s
 {
+  struct visplane_s	*next; // [crispy] hash chain, see R_FindPlane()
   fixed_t		height;
   int			picnum;
   int			lightlevel;
   int			minx;
   int			maxx;
   
-  // leave pads for [minx-1]/[maxx+1]
-  
-  unsigned int		pad1; // [crispy] hires / 32-bit integer math
-  // Here lies the rub for all
-  //  dynamic resize/change of resolution.
-  unsigned int		top[MAXWIDTH]; // [crispy] hires / 32-bit integer math
-  unsigned int		pad2; // [crispy] hires / 32-bit integer math
-  unsigned int		pad3; // [crispy] hires / 32-bit integer math
-  // See above.
-  unsigned int		bottom[MAXWIDTH]; // [crispy] hires / 32-bit integer math
-  unsigned int		pad4; // [crispy] hires / 32-bit integer math
+  // [crispy] top[] and bottom[] are carved out of the per-frame plane
+  // arena and hold viewwidth entries each, plus a pad on either side
+  // for [minx-1]/[maxx+1]. Only the [minx..maxx] range is ever cleared.
+  unsigned int		*top; // [crispy] hires / 32-bit integer math
+  unsigned int		*bottom; // [crispy] hires / 32-bit integer math
 
 } visplane_t;
 
@@ -25,10 +25,13 @@
 #include "deh_main.h"
 
 #include "i_system.h"
+#include "i_video.h" // [crispy] I_GetPaletteIndex()
 #include "z_zone.h"
 #include "w_wad.h"
+#include "m_argv.h"
 
 #include "r_local.h"
+#include "r_bmaps.h"
 
 // Needs access to LFB (guess what).
 #include "v_video.h"
@@ -57,6 +60,14 @@
 byte*		viewimage; 
 int		viewwidth;
 int		scaledviewwidth;
+int		scaledviewheight;
+int		renderwidth;
+int		renderpitch;
+
+// [crispy] render scale, see R_InitBuffer()
+static pixel_t*	renderbuffer;
+static int	scalecolumn[MAXWIDTH];
+static int	scalerow[MAXHEIGHT];
 int		viewheight;
 int		viewwindowx;
 int		viewwindowy; 
@@ -79,19 +90,16 @@ static pixel_t *background_buffer = NULL;
 // R_DrawColumn
 // Source is the top of the column to scale.
 //
-lighttable_t*		dc_colormap[2]; // [crispy] brightmaps
-int			dc_x; 
-int			dc_yl; 
-int			dc_yh; 
-fixed_t			dc_iscale; 
-fixed_t			dc_texturemid;
-int			dc_texheight; // [crispy] Tutti-Frutti fix
+THREADLOCAL lighttable_t*		dc_colormap[2]; // [crispy] brightmaps
+THREADLOCAL int			dc_x; 
+THREADLOCAL int			dc_yl; 
+THREADLOCAL int			dc_yh; 
+THREADLOCAL fixed_t			dc_iscale; 
+THREADLOCAL fixed_t			dc_texturemid;
+THREADLOCAL int			dc_texheight; // [crispy] Tutti-Frutti fix
 
 // first pixel in a column (possibly virtual) 
-byte*			dc_source;		
-
-// just for profiling 
-int			dccount;
+THREADLOCAL byte*			dc_source;		
 
 //
 // A column is a vertical slice/span from a wall texture that,
@@ -110,6 +118,7 @@ void R_DrawColumn (void)
     fixed_t		frac;
     fixed_t		fracstep;	 
     int			heightmask = dc_texheight - 1;
+    const lighttable_t *const colormap = R_FusedColormap(dc_colormap, dc_brightmap, fullcolormap);
  
     count = dc_yh - dc_yl; 
 
@@ -118,9 +127,9 @@ void R_DrawColumn (void)
 	return; 
 				 
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
+    if ((unsigned)dc_x >= MAXWIDTH
 	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT) 
+	|| dc_yh >= MAXHEIGHT) 
 	I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x); 
 #endif 
 
@@ -154,9 +163,9 @@ void R_DrawColumn (void)
     {
 	// [crispy] brightmaps
 	const byte source = dc_source[frac>>FRACBITS];
-	*dest = fullcolormap[dc_colormap[dc_brightmap[source]][source]];
+	*dest = colormap[source];
 
-	dest += SCREENWIDTH;
+	dest += renderpitch;
 	if ((frac += fracstep) >= heightmask)
 	    frac -= heightmask;
     } while (count--);
@@ -169,15 +178,196 @@ void R_DrawColumn (void)
 	//  using a lighting/special effects LUT.
 	// [crispy] brightmaps
 	const byte source = dc_source[(frac>>FRACBITS)&heightmask];
-	*dest = fullcolormap[dc_colormap[dc_brightmap[source]][source]];
+	*dest = colormap[source];
 	
-	dest += SCREENWIDTH; 
+	dest += renderpitch; 
 	frac += fracstep;
 	
     } while (count--); 
   }
 } 
 
+//
+// [crispy] Batched wall columns.
+// R_RenderSegLoop() queues adjacent wall columns that share their
+//  lighting, brightmap and texture height, and draws them four at a
+//  time.  The rows shared by all queued columns are written one row
+//  at a time instead of striding down the framebuffer once per column,
+//  the ragged ends are drawn column by column.  Every pixel is computed
+//  exactly as in R_DrawColumn().
+//
+
+static inline void
+R_BatchTexel
+( const colbatch_t*	batch,
+  const lighttable_t*	colormap,
+  int			i,
+  pixel_t*		dest,
+  fixed_t*		frac,
+  int			heightmask,
+  boolean		npot )
+{
+    byte source;
+
+    if (npot)
+    {
+	source = batch->source[i][*frac>>FRACBITS];
+	if ((*frac += batch->iscale[i]) >= heightmask)
+	    *frac -= heightmask;
+    }
+    else
+    {
+	source = batch->source[i][(*frac>>FRACBITS)&heightmask];
+	*frac += batch->iscale[i];
+    }
+
+    *dest = colormap[source];
+}
+
+void R_FlushColumns (colbatch_t *batch)
+{
+    pixel_t*		dest[COLBATCH];
+    fixed_t		frac[COLBATCH];
+    const int		num = batch->num;
+    int			heightmask = batch->texheight - 1;
+    const boolean	npot = (batch->texheight & heightmask) != 0;
+    const lighttable_t*	colormap;
+    int			top, bottom;
+    int			i, y;
+
+    if (!num)
+	return;
+
+    batch->num = 0;
+
+    // [crispy] brightmaps
+    colormap = R_FusedColormap(batch->colormap, batch->brightmap, fullcolormap);
+
+    // heightmask is the Tutti-Frutti fix -- killough
+    if (npot)
+    {
+	heightmask++;
+	heightmask <<= FRACBITS;
+    }
+
+    top = batch->yl[0];
+    bottom = batch->yh[0];
+
+    for (i = 0; i < num; i++)
+    {
+#ifdef RANGECHECK
+	if ((unsigned)(batch->x + i) >= MAXWIDTH
+	    || batch->yl[i] < 0
+	    || batch->yh[i] >= MAXHEIGHT)
+	    I_Error ("R_FlushColumns: %i to %i at %i",
+	             batch->yl[i], batch->yh[i], batch->x + i);
+#endif
+
+	dest[i] = ylookup[batch->yl[i]] + columnofs[batch->x + i];
+	frac[i] = batch->texturemid[i]
+	        + (batch->yl[i]-centery)*batch->iscale[i];
+
+	if (npot)
+	{
+	    if (frac[i] < 0)
+		while ((frac[i] += heightmask) < 0);
+	    else
+		while (frac[i] >= heightmask)
+		    frac[i] -= heightmask;
+	}
+
+	top = MAX(top, batch->yl[i]);
+	bottom = MIN(bottom, batch->yh[i]);
+    }
+
+    // no rows are shared, the columns are drawn on their own
+    if (top > bottom)
+	bottom = top - 1;
+
+    for (i = 0; i < num; i++)
+    {
+	const int yh = MIN(batch->yh[i], top - 1);
+
+	for (y = batch->yl[i]; y <= yh; y++)
+	{
+	    R_BatchTexel(batch, colormap, i, dest[i], &frac[i], heightmask, npot);
+	    dest[i] += renderpitch;
+	}
+    }
+
+    for (y = top; y <= bottom; y++)
+    {
+	for (i = 0; i < num; i++)
+	{
+	    R_BatchTexel(batch, colormap, i, dest[i], &frac[i], heightmask, npot);
+	    dest[i] += renderpitch;
+	}
+    }
+
+    for (i = 0; i < num; i++)
+    {
+	const int yl = MAX(batch->yl[i], bottom + 1);
+
+	for (y = yl; y <= batch->yh[i]; y++)
+	{
+	    R_BatchTexel(batch, colormap, i, dest[i], &frac[i], heightmask, npot);
+	    dest[i] += renderpitch;
+	}
+    }
+}
+
+//
+// R_BatchColumn
+// Queues the column set up in the dc_* variables.  Only the full
+//  detail wall drawer is batched, anything else is drawn right away.
+//
+void R_BatchColumn (colbatch_t *batch)
+{
+    int i;
+
+    // Zero length, column does not exceed a pixel.
+    if (dc_yh < dc_yl)
+	return;
+
+    rstats.columns++;
+    rstats.pixels += (dc_yh - dc_yl + 1) << detailshift;
+
+    if (colfunc != R_DrawColumn)
+    {
+	colfunc ();
+	return;
+    }
+
+    if (batch->num
+     && (dc_x != batch->x + batch->num
+      || dc_colormap[0] != batch->colormap[0]
+      || dc_colormap[1] != batch->colormap[1]
+      || dc_brightmap != batch->brightmap
+      || dc_texheight != batch->texheight))
+    {
+	R_FlushColumns(batch);
+    }
+
+    if (!batch->num)
+    {
+	batch->x = dc_x;
+	batch->colormap[0] = dc_colormap[0];
+	batch->colormap[1] = dc_colormap[1];
+	batch->brightmap = dc_brightmap;
+	batch->texheight = dc_texheight;
+    }
+
+    i = batch->num++;
+    batch->yl[i] = dc_yl;
+    batch->yh[i] = dc_yh;
+    batch->iscale[i] = dc_iscale;
+    batch->texturemid[i] = dc_texturemid;
+    batch->source[i] = dc_source;
+
+    if (batch->num == COLBATCH)
+	R_FlushColumns(batch);
+}
+
 void R_DrawColumnLow (void) 
 { 
     int			count; 
@@ -187,6 +377,7 @@ void R_DrawColumnLow (void)
     fixed_t		fracstep;	 
     int                 x;
     int			heightmask = dc_texheight - 1;
+    const lighttable_t *const colormap = R_FusedColormap(dc_colormap, dc_brightmap, NULL);
  
     count = dc_yh - dc_yl; 
 
@@ -195,14 +386,13 @@ void R_DrawColumnLow (void)
 	return; 
 				 
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
+    if ((unsigned)dc_x >= MAXWIDTH
 	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT)
+	|| dc_yh >= MAXHEIGHT)
     {
 	
 	I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x);
     }
-    //	dccount++; 
 #endif 
     // Blocky mode, need to multiply by 2.
     x = dc_x << 1;
@@ -229,10 +419,10 @@ void R_DrawColumnLow (void)
     {
 	// [crispy] brightmaps
 	const byte source = dc_source[frac>>FRACBITS];
-	*dest2 = *dest = dc_colormap[dc_brightmap[source]][source];
+	*dest2 = *dest = colormap[source];
 
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += renderpitch;
+	dest2 += renderpitch;
 
 	if ((frac += fracstep) >= heightmask)
 	    frac -= heightmask;
@@ -245,9 +435,9 @@ void R_DrawColumnLow (void)
 	// Hack. Does not work corretly.
 	// [crispy] brightmaps
 	const byte source = dc_source[(frac>>FRACBITS)&heightmask];
-	*dest2 = *dest = dc_colormap[dc_brightmap[source]][source];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	*dest2 = *dest = colormap[source];
+	dest += renderpitch;
+	dest2 += renderpitch;
 
 	frac += fracstep; 
 
@@ -274,7 +464,7 @@ int	fuzzoffset[FUZZTABLE] =
     FUZZOFF,FUZZOFF,-FUZZOFF,FUZZOFF,FUZZOFF,-FUZZOFF,FUZZOFF 
 }; 
 
-int	fuzzpos = 0; 
+THREADLOCAL int	fuzzpos = 0; 
 
 // [crispy] draw fuzz effect independent of rendering frame rate
 static int fuzzpos_tic;
@@ -320,9 +510,17 @@ void R_DrawFuzzColumn (void)
     if (count < 0) 
 	return; 
 
+    // Columns of other strips are only counted, so that the
+    // fuzz pattern is the same as with a single thread.
+    if (dc_x < stripx1 || dc_x > stripx2)
+    {
+	fuzzpos = (fuzzpos + count + 1) % FUZZTABLE;
+	return;
+    }
+
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
-	|| dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if ((unsigned)dc_x >= MAXWIDTH
+	|| dc_yl < 0 || dc_yh >= MAXHEIGHT)
     {
 	I_Error ("R_DrawFuzzColumn: %i to %i at %i",
 		 dc_yl, dc_yh, dc_x);
@@ -344,13 +542,13 @@ void R_DrawFuzzColumn (void)
 	//  a pixel that is either one column
 	//  left or right of the current one.
 	// Add index from colormap to index.
-	*dest = fullcolormap[6*256+dest[SCREENWIDTH*fuzzoffset[fuzzpos]]]; 
+	*dest = fullcolormap[6*256+dest[renderpitch*fuzzoffset[fuzzpos]]]; 
 
 	// Clamp table lookup index.
 	if (++fuzzpos == FUZZTABLE) 
 	    fuzzpos = 0;
 	
-	dest += SCREENWIDTH;
+	dest += renderpitch;
 
 	frac += fracstep; 
     } while (count--); 
@@ -359,7 +557,7 @@ void R_DrawFuzzColumn (void)
     // draw one extra line using only pixels of that line and the one above
     if (cutoff)
     {
-	*dest = fullcolormap[6*256+dest[SCREENWIDTH*(fuzzoffset[fuzzpos]-FUZZOFF)/2]];
+	*dest = fullcolormap[6*256+dest[renderpitch*(fuzzoffset[fuzzpos]-FUZZOFF)/2]];
     }
 } 
 
@@ -392,13 +590,20 @@ void R_DrawFuzzColumnLow (void)
     if (count < 0) 
 	return; 
 
+    // see R_DrawFuzzColumn()
+    if (dc_x < stripx1 || dc_x > stripx2)
+    {
+	fuzzpos = (fuzzpos + count + 1) % FUZZTABLE;
+	return;
+    }
+
     // low detail mode, need to multiply by 2
     
     x = dc_x << 1;
     
 #ifdef RANGECHECK 
-    if ((unsigned)x >= SCREENWIDTH
-	|| dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if ((unsigned)x >= MAXWIDTH
+	|| dc_yl < 0 || dc_yh >= MAXHEIGHT)
     {
 	I_Error ("R_DrawFuzzColumn: %i to %i at %i",
 		 dc_yl, dc_yh, dc_x);
@@ -421,15 +626,15 @@ void R_DrawFuzzColumnLow (void)
 	//  a pixel that is either one column
 	//  left or right of the current one.
 	// Add index from colormap to index.
-	*dest = fullcolormap[6*256+dest[SCREENWIDTH*fuzzoffset[fuzzpos]]];
-	*dest2 = fullcolormap[6*256+dest2[SCREENWIDTH*fuzzoffset[fuzzpos]]];
+	*dest = fullcolormap[6*256+dest[renderpitch*fuzzoffset[fuzzpos]]];
+	*dest2 = fullcolormap[6*256+dest2[renderpitch*fuzzoffset[fuzzpos]]];
 
 	// Clamp table lookup index.
 	if (++fuzzpos == FUZZTABLE) 
 	    fuzzpos = 0;
 	
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += renderpitch;
+	dest2 += renderpitch;
 
 	frac += fracstep; 
     } while (count--); 
@@ -438,8 +643,8 @@ void R_DrawFuzzColumnLow (void)
     // draw one extra line using only pixels of that line and the one above
     if (cutoff)
     {
-	*dest = fullcolormap[6*256+dest[SCREENWIDTH*(fuzzoffset[fuzzpos]-FUZZOFF)/2]];
-	*dest2 = fullcolormap[6*256+dest2[SCREENWIDTH*(fuzzoffset[fuzzpos]-FUZZOFF)/2]];
+	*dest = fullcolormap[6*256+dest[renderpitch*(fuzzoffset[fuzzpos]-FUZZOFF)/2]];
+	*dest2 = fullcolormap[6*256+dest2[renderpitch*(fuzzoffset[fuzzpos]-FUZZOFF)/2]];
     }
 } 
  
@@ -456,7 +661,7 @@ void R_DrawFuzzColumnLow (void)
 //  of the BaronOfHell, the HellKnight, uses
 //  identical sprites, kinda brightened up.
 //
-byte*	dc_translation;
+THREADLOCAL byte*	dc_translation;
 byte*	translationtables;
 
 void R_DrawTranslatedColumn (void) 
@@ -471,9 +676,9 @@ void R_DrawTranslatedColumn (void)
 	return; 
 				 
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
+    if ((unsigned)dc_x >= MAXWIDTH
 	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT)
+	|| dc_yh >= MAXHEIGHT)
     {
 	I_Error ( "R_DrawColumn: %i to %i at %i",
 		  dc_yl, dc_yh, dc_x);
@@ -497,7 +702,7 @@ void R_DrawTranslatedColumn (void)
 	// Thus the "green" ramp of the player 0 sprite
 	//  is mapped to gray, red, black/indigo. 
 	*dest = fullcolormap[dc_colormap[0][dc_translation[dc_source[frac>>FRACBITS]]]];
-	dest += SCREENWIDTH;
+	dest += renderpitch;
 	
 	frac += fracstep; 
     } while (count--); 
@@ -520,9 +725,9 @@ void R_DrawTranslatedColumnLow (void)
     x = dc_x << 1;
 				 
 #ifdef RANGECHECK 
-    if ((unsigned)x >= SCREENWIDTH
+    if ((unsigned)x >= MAXWIDTH
 	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT)
+	|| dc_yh >= MAXHEIGHT)
     {
 	I_Error ( "R_DrawColumn: %i to %i at %i",
 		  dc_yl, dc_yh, x);
@@ -548,8 +753,8 @@ void R_DrawTranslatedColumnLow (void)
 	//  is mapped to gray, red, black/indigo. 
 	*dest = dc_colormap[0][dc_translation[dc_source[frac>>FRACBITS]]];
 	*dest2 = dc_colormap[0][dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += renderpitch;
+	dest2 += renderpitch;
 	
 	frac += fracstep; 
     } while (count--); 
@@ -570,9 +775,9 @@ void R_DrawTLColumn (void)
 	return;
 
 #ifdef RANGECHECK
-    if ((unsigned)dc_x >= SCREENWIDTH
+    if ((unsigned)dc_x >= MAXWIDTH
 	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT)
+	|| dc_yh >= MAXHEIGHT)
     {
 	I_Error ( "R_DrawColumn: %i to %i at %i",
 		  dc_yl, dc_yh, dc_x);
@@ -588,7 +793,7 @@ void R_DrawTLColumn (void)
     {
         // actual translucency map lookup taken from boom202s/R_DRAW.C:255
         *dest = tranmap[(*dest<<8)+dc_colormap[0][dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
+	dest += renderpitch;
 
 	frac += fracstep;
     } while (count--);
@@ -611,9 +816,9 @@ void R_DrawTLColumnLow (void)
     x = dc_x << 1;
 
 #ifdef RANGECHECK
-    if ((unsigned)x >= SCREENWIDTH
+    if ((unsigned)x >= MAXWIDTH
 	|| dc_yl < 0
-	|| dc_yh >= SCREENHEIGHT)
+	|| dc_yh >= MAXHEIGHT)
     {
 	I_Error ( "R_DrawColumn: %i to %i at %i",
 		  dc_yl, dc_yh, x);
@@ -630,8 +835,8 @@ void R_DrawTLColumnLow (void)
     {
 	*dest = tranmap[(*dest<<8)+dc_colormap[0][dc_source[frac>>FRACBITS]]];
 	*dest2 = tranmap[(*dest2<<8)+dc_colormap[0][dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += renderpitch;
+	dest2 += renderpitch;
 
 	frac += fracstep;
     } while (count--);
@@ -684,23 +889,23 @@ void R_InitTranslationTables (void)
 // In consequence, flats are not stored by column (like walls),
 //  and the inner loop has to step in texture space u and v.
 //
-int			ds_y; 
-int			ds_x1; 
-int			ds_x2;
+THREADLOCAL int			ds_y; 
+THREADLOCAL int			ds_x1; 
+THREADLOCAL int			ds_x2;
 
-lighttable_t*		ds_colormap[2];
-byte*			ds_brightmap;
+THREADLOCAL lighttable_t*		ds_colormap[2];
+THREADLOCAL byte*			ds_brightmap;
 
-fixed_t			ds_xfrac; 
-fixed_t			ds_yfrac; 
-fixed_t			ds_xstep; 
-fixed_t			ds_ystep;
+THREADLOCAL fixed_t			ds_xfrac; 
+THREADLOCAL fixed_t			ds_yfrac; 
+THREADLOCAL fixed_t			ds_xstep; 
+THREADLOCAL fixed_t			ds_ystep;
 
 // start of a 64*64 tile image 
-byte*			ds_source;	
+THREADLOCAL byte*			ds_source;	
 
-// just for profiling
-int			dscount;
+// [crispy] LOD level of ds_source
+THREADLOCAL int				ds_lod;
 
 
 //
@@ -712,17 +917,17 @@ void R_DrawSpan (void)
     int count;
     int spot;
     unsigned int xtemp, ytemp;
+    const lighttable_t *const colormap = R_FusedColormap(ds_colormap, ds_brightmap, fullcolormap);
 
 #ifdef RANGECHECK
     if (ds_x2 < ds_x1
 	|| ds_x1<0
-	|| ds_x2>=SCREENWIDTH
-	|| (unsigned)ds_y>SCREENHEIGHT)
+	|| ds_x2>=MAXWIDTH
+	|| (unsigned)ds_y>MAXHEIGHT)
     {
 	I_Error( "R_DrawSpan: %i to %i at %i",
 		 ds_x1,ds_x2,ds_y);
     }
-//	dscount++;
 #endif
 
     dest = ylookup[ds_y] + columnofs[ds_x1];
@@ -742,7 +947,7 @@ void R_DrawSpan (void)
 	// Lookup pixel from flat texture tile,
 	//  re-index using light/colormap.
 	source = ds_source[spot];
-	*dest++ = fullcolormap[ds_colormap[ds_brightmap[source]][source]];
+	*dest++ = colormap[source];
 
         ds_xfrac += ds_xstep;
         ds_yfrac += ds_ystep;
@@ -759,12 +964,13 @@ void R_DrawSpanLow (void)
     pixel_t *dest;
     int count;
     int spot;
+    const lighttable_t *const colormap = R_FusedColormap(ds_colormap, ds_brightmap, NULL);
 
 #ifdef RANGECHECK
     if (ds_x2 < ds_x1
 	|| ds_x1<0
-	|| ds_x2>=SCREENWIDTH
-	|| (unsigned)ds_y>SCREENHEIGHT)
+	|| ds_x2>=MAXWIDTH
+	|| (unsigned)ds_y>MAXHEIGHT)
     {
 	I_Error( "R_DrawSpan: %i to %i at %i",
 		 ds_x1,ds_x2,ds_y);
@@ -791,22 +997,348 @@ void R_DrawSpanLow (void)
 	// Lowres/blocky mode does it twice,
 	//  while scale is adjusted appropriately.
 	source = ds_source[spot];
-	*dest++ = ds_colormap[ds_brightmap[source]][source];
-	*dest++ = ds_colormap[ds_brightmap[source]][source];
+	*dest++ = colormap[source];
+	*dest++ = colormap[source];
+
+	ds_xfrac += ds_xstep;
+	ds_yfrac += ds_ystep;
+
+
+    } while (count--);
+}
+
+//
+// R_DrawSpanLOD
+// [crispy] R_DrawSpan() for a flat LOD level, ds_source is a tile
+//  of (64>>ds_lod)*(64>>ds_lod) texels.
+//
+void R_DrawSpanLOD (void)
+{
+    pixel_t *dest;
+    int count;
+    const int fracbits = FRACBITS + ds_lod;
+    const int sizebits = 6 - ds_lod;
+    const unsigned int mask = (1 << sizebits) - 1;
+    const lighttable_t *const colormap = R_FusedColormap(ds_colormap, ds_brightmap, fullcolormap);
+
+    dest = ylookup[ds_y] + columnofs[ds_x1];
+    count = ds_x2 - ds_x1;
+
+    do
+    {
+	const unsigned int xtemp = ((unsigned int) ds_xfrac >> fracbits) & mask;
+	const unsigned int ytemp = ((unsigned int) ds_yfrac >> fracbits) & mask;
+
+	*dest++ = colormap[ds_source[(ytemp << sizebits) | xtemp]];
 
 	ds_xfrac += ds_xstep;
 	ds_yfrac += ds_ystep;
+    } while (count--);
+}
+
+//
+// R_DrawSpanLowLOD
+//
+void R_DrawSpanLowLOD (void)
+{
+    pixel_t *dest;
+    int count;
+    const int fracbits = FRACBITS + ds_lod;
+    const int sizebits = 6 - ds_lod;
+    const unsigned int mask = (1 << sizebits) - 1;
+    const lighttable_t *const colormap = R_FusedColormap(ds_colormap, ds_brightmap, NULL);
+
+    count = ds_x2 - ds_x1;
+
+    // Blocky mode, need to multiply by 2.
+    ds_x1 <<= 1;
+    ds_x2 <<= 1;
+
+    dest = ylookup[ds_y] + columnofs[ds_x1];
 
+    do
+    {
+	const unsigned int xtemp = ((unsigned int) ds_xfrac >> fracbits) & mask;
+	const unsigned int ytemp = ((unsigned int) ds_yfrac >> fracbits) & mask;
+	const byte source = ds_source[(ytemp << sizebits) | xtemp];
 
+	*dest++ = colormap[source];
+	*dest++ = colormap[source];
+
+	ds_xfrac += ds_xstep;
+	ds_yfrac += ds_ystep;
     } while (count--);
 }
 
+//
+// [crispy] Vectorized span drawers.
+// Neither simd128 nor SSE2 have a gather, so only the texture offsets
+// of a span are computed in vector registers, eight pixels per
+// iteration, and the lookups stay scalar.  The lanes wrap around
+// exactly like the scalar fixed point additions and the masks only
+// keep bits 16-21 of each coordinate, so the output is the same.
+//
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+typedef v128_t spanvec_t;
+#define VLOAD(p)	wasm_v128_load(p)
+#define VSTORE(p, v)	wasm_v128_store(p, v)
+#define VSPLAT(x)	wasm_i32x4_splat(x)
+#define VADD(a, b)	wasm_i32x4_add(a, b)
+#define VSHR(a, n)	wasm_u32x4_shr(a, n)
+#define VAND(a, b)	wasm_v128_and(a, b)
+#define VOR(a, b)	wasm_v128_or(a, b)
+#define HAVE_SPANVEC
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i spanvec_t;
+#define VLOAD(p)	_mm_loadu_si128((const __m128i *) (p))
+#define VSTORE(p, v)	_mm_storeu_si128((__m128i *) (p), v)
+#define VSPLAT(x)	_mm_set1_epi32(x)
+#define VADD(a, b)	_mm_add_epi32(a, b)
+#define VSHR(a, n)	_mm_srli_epi32(a, n)
+#define VAND(a, b)	_mm_and_si128(a, b)
+#define VOR(a, b)	_mm_or_si128(a, b)
+#define HAVE_SPANVEC
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+typedef uint32x4_t spanvec_t;
+#define VLOAD(p)	vld1q_u32(p)
+#define VSTORE(p, v)	vst1q_u32(p, v)
+#define VSPLAT(x)	vdupq_n_u32(x)
+#define VADD(a, b)	vaddq_u32(a, b)
+#define VSHR(a, n)	vshrq_n_u32(a, n)
+#define VAND(a, b)	vandq_u32(a, b)
+#define VOR(a, b)	vorrq_u32(a, b)
+#define HAVE_SPANVEC
+#endif
+
+#ifdef HAVE_SPANVEC
+
+#define SPANBATCH 8
+
+//
+// R_SpanSpots
+// Fills spots[] with the flat offsets of the next count pixels and
+//  advances ds_xfrac and ds_yfrac past them.  The array is written
+//  in whole batches, so it needs room for SPANBATCH-1 extra entries.
+//
+static void R_SpanSpots (unsigned int *spots, int count)
+{
+    unsigned int	xfrac[4], yfrac[4];
+    spanvec_t		x0, x1, y0, y1;
+    spanvec_t		xstep, ystep;
+    spanvec_t		xmask, ymask;
+    int			i;
+
+    for (i = 0; i < 4; i++)
+    {
+	xfrac[i] = (unsigned int) ds_xfrac + i * (unsigned int) ds_xstep;
+	yfrac[i] = (unsigned int) ds_yfrac + i * (unsigned int) ds_ystep;
+    }
+
+    x0 = VLOAD(xfrac);
+    y0 = VLOAD(yfrac);
+    x1 = VADD(x0, VSPLAT(4 * (unsigned int) ds_xstep));
+    y1 = VADD(y0, VSPLAT(4 * (unsigned int) ds_ystep));
+
+    xstep = VSPLAT(SPANBATCH * (unsigned int) ds_xstep);
+    ystep = VSPLAT(SPANBATCH * (unsigned int) ds_ystep);
+    xmask = VSPLAT(0x3f);
+    ymask = VSPLAT(0x0fc0);
+
+    for (i = 0; i < count; i += SPANBATCH)
+    {
+	VSTORE(spots + i, VOR(VAND(VSHR(x0, 16), xmask),
+	                      VAND(VSHR(y0, 10), ymask)));
+	VSTORE(spots + i + 4, VOR(VAND(VSHR(x1, 16), xmask),
+	                          VAND(VSHR(y1, 10), ymask)));
+
+	x0 = VADD(x0, xstep);
+	y0 = VADD(y0, ystep);
+	x1 = VADD(x1, xstep);
+	y1 = VADD(y1, ystep);
+    }
+
+    ds_xfrac = (unsigned int) ds_xfrac + count * (unsigned int) ds_xstep;
+    ds_yfrac = (unsigned int) ds_yfrac + count * (unsigned int) ds_ystep;
+}
+
+static void R_DrawSpanVec (void)
+{
+    unsigned int spots[MAXWIDTH + SPANBATCH - 1];
+    pixel_t *dest;
+    int count;
+    int i;
+    const lighttable_t *const colormap = R_FusedColormap(ds_colormap, ds_brightmap, fullcolormap);
+
+#ifdef RANGECHECK
+    if (ds_x2 < ds_x1
+	|| ds_x1<0
+	|| ds_x2>=MAXWIDTH
+	|| (unsigned)ds_y>MAXHEIGHT)
+    {
+	I_Error( "R_DrawSpan: %i to %i at %i",
+		 ds_x1,ds_x2,ds_y);
+    }
+#endif
+
+    dest = ylookup[ds_y] + columnofs[ds_x1];
+    count = ds_x2 - ds_x1 + 1;
+
+    R_SpanSpots(spots, count);
+
+    for (i = 0; i < count; i++)
+    {
+	const byte source = ds_source[spots[i]];
+	*dest++ = colormap[source];
+    }
+}
+
+static void R_DrawSpanLowVec (void)
+{
+    unsigned int spots[MAXWIDTH + SPANBATCH - 1];
+    pixel_t *dest;
+    int count;
+    int i;
+    const lighttable_t *const colormap = R_FusedColormap(ds_colormap, ds_brightmap, NULL);
+
+#ifdef RANGECHECK
+    if (ds_x2 < ds_x1
+	|| ds_x1<0
+	|| ds_x2>=MAXWIDTH
+	|| (unsigned)ds_y>MAXHEIGHT)
+    {
+	I_Error( "R_DrawSpan: %i to %i at %i",
+		 ds_x1,ds_x2,ds_y);
+    }
+#endif
+
+    count = ds_x2 - ds_x1 + 1;
+
+    // Blocky mode, need to multiply by 2.
+    ds_x1 <<= 1;
+    ds_x2 <<= 1;
+
+    dest = ylookup[ds_y] + columnofs[ds_x1];
+
+    R_SpanSpots(spots, count);
+
+    for (i = 0; i < count; i++)
+    {
+	const byte source = ds_source[spots[i]];
+	*dest++ = colormap[source];
+	*dest++ = colormap[source];
+    }
+}
+
+#endif
+
+//
+// [crispy] Overdraw heatmap.
+// With render_heatmap set, these replace all the drawers and count the
+//  writes to each pixel instead of drawing it.  The view starts out
+//  cleared to zero for the HOM indicator, R_DrawHeatmap() then turns
+//  the counts into colors.
+//
+
+static inline void R_HeatPixels (pixel_t *dest, int count, int step)
+{
+    do
+    {
+	if (*dest < 0xff)
+	    (*dest)++;
+	dest += step;
+    } while (--count);
+}
+
+void R_DrawColumnHeat (void)
+{
+    const int count = dc_yh - dc_yl + 1;
+
+    if (count <= 0 || dc_x < stripx1 || dc_x > stripx2)
+	return;
+
+    if (detailshift)
+    {
+	R_HeatPixels(ylookup[dc_yl] + columnofs[dc_x << 1], count, renderpitch);
+	R_HeatPixels(ylookup[dc_yl] + columnofs[(dc_x << 1) + 1], count, renderpitch);
+    }
+    else
+    {
+	R_HeatPixels(ylookup[dc_yl] + columnofs[dc_x], count, renderpitch);
+    }
+}
+
+void R_DrawSpanHeat (void)
+{
+    R_HeatPixels(ylookup[ds_y] + columnofs[ds_x1 << detailshift],
+                 (ds_x2 - ds_x1 + 1) << detailshift, 1);
+}
+
+void R_DrawHeatmap (void)
+{
+    // black for none (HOM), blue, cyan, green, yellow, orange, red,
+    // magenta and white for eight and more writes
+    static const byte heat[][3] = {
+	{0, 0, 0}, {0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0},
+	{255, 128, 0}, {255, 0, 0}, {255, 0, 255}, {255, 255, 255},
+    };
+    static pixel_t heatcolors[arrlen(heat)];
+    static boolean initialized = false;
+    int x, y;
+
+    if (!initialized)
+    {
+	for (x = 0; x < arrlen(heat); x++)
+	    heatcolors[x] = I_GetPaletteIndex(heat[x][0], heat[x][1], heat[x][2]);
+	initialized = true;
+    }
+
+    for (y = 0; y < viewheight; y++)
+    {
+	pixel_t *dest = ylookup[y] + columnofs[0];
+
+	for (x = 0; x < renderwidth; x++)
+	    dest[x] = heatcolors[MIN(dest[x], arrlen(heat) - 1)];
+    }
+}
+
+void (*hispanfunc) (void) = R_DrawSpan;
+void (*lospanfunc) (void) = R_DrawSpanLow;
+
+//
+// R_InitSpanFuncs
+// Picks the span drawers once at startup.
+//
+void R_InitSpanFuncs (void)
+{
+#ifdef HAVE_SPANVEC
+    //!
+    // @category video
+    //
+    // Don't use the vectorized floor and ceiling drawers.
+    //
+
+    if (!M_ParmExists("-nosimd"))
+    {
+	hispanfunc = R_DrawSpanVec;
+	lospanfunc = R_DrawSpanLowVec;
+    }
+#endif
+}
+
 //
 // R_InitBuffer 
 // Creats lookup tables that avoid
 //  multiplies and other hazzles
 //  for getting the framebuffer address
 //  of a pixel to draw.
+// [crispy] width and height are the size of the view window, the view
+//  itself is renderwidth by viewheight pixels.  If that differs, it is
+//  drawn into renderbuffer, renderpitch pixels to the row, and scaled
+//  to the window by R_ScaleView().
 //
 void
 R_InitBuffer
@@ -820,20 +1352,82 @@ R_InitBuffer
     //  with border and/or status bar.
     viewwindowx = (SCREENWIDTH-width) >> 1; 
 
-    // Column offset. For windows.
-    for (i=0 ; i<width ; i++) 
-	columnofs[i] = viewwindowx + i;
-
     // Samw with base row offset.
     if (width == SCREENWIDTH) 
 	viewwindowy = 0; 
     else 
 	viewwindowy = (SCREENHEIGHT-SBARHEIGHT-height) >> 1; 
 
-    // Preclaculate all row offsets.
-    for (i=0 ; i<height ; i++) 
-	ylookup[i] = I_VideoBuffer + (i+viewwindowy)*SCREENWIDTH; 
+    if (renderwidth == width && viewheight == height)
+    {
+	// Column offset. For windows.
+	for (i=0 ; i<width ; i++) 
+	    columnofs[i] = viewwindowx + i;
+
+	// Preclaculate all row offsets.
+	for (i=0 ; i<height ; i++) 
+	    ylookup[i] = I_VideoBuffer + (i+viewwindowy)*SCREENWIDTH; 
+
+	renderpitch = SCREENWIDTH;
+	return;
+    }
+
+    // large enough for the view at MAXRENDERSCALE
+    if (renderbuffer == NULL)
+	renderbuffer = Z_Malloc((SCREENWIDTH * MAXRENDERSCALE / 100)
+	                        * (SCREENHEIGHT * MAXRENDERSCALE / 100)
+	                        * sizeof(*renderbuffer), PU_STATIC, NULL);
+
+    renderpitch = renderwidth;
+
+    for (i=0 ; i<renderwidth ; i++) 
+	columnofs[i] = i;
+
+    for (i=0 ; i<viewheight ; i++) 
+	ylookup[i] = renderbuffer + i*renderpitch; 
+
+    for (i=0 ; i<width ; i++)
+	scalecolumn[i] = i * renderwidth / width;
+
+    for (i=0 ; i<height ; i++)
+	scalerow[i] = i * viewheight / height;
 } 
+
+//
+// R_ScaleView
+// [crispy] Stretches the view from renderbuffer to the view window.
+//  A view rendered larger than the window is also handed to the video
+//  code, which shows it in full where the screen is upscaled.
+//
+void R_ScaleView (void)
+{
+    pixel_t	*src, *dest;
+    int		x, y;
+
+    if (renderwidth == scaledviewwidth && viewheight == scaledviewheight)
+	return;
+
+    dest = I_VideoBuffer + viewwindowy*SCREENWIDTH + viewwindowx;
+
+    for (y=0 ; y<scaledviewheight ; y++, dest += SCREENWIDTH)
+    {
+	// repeated rows are copied from the row above
+	if (y && scalerow[y] == scalerow[y-1])
+	{
+	    memcpy(dest, dest - SCREENWIDTH, scaledviewwidth * sizeof(*dest));
+	    continue;
+	}
+
+	src = ylookup[scalerow[y]];
+
+	for (x=0 ; x<scaledviewwidth ; x++)
+	    dest[x] = src[scalecolumn[x]];
+    }
+
+    if (renderwidth > scaledviewwidth || viewheight > scaledviewheight)
+	I_SetHiresView(renderbuffer, renderpitch, renderwidth, viewheight,
+	               viewwindowx, viewwindowy, scaledviewwidth, scaledviewheight);
+}
  
  
 
@@ -916,14 +1510,14 @@ void R_FillBackScreen (void)
     patch = W_CacheLumpName(DEH_String("brdr_b"),PU_CACHE);
 
     for (x=0 ; x<(scaledviewwidth) ; x+=8)
-	V_DrawPatch((viewwindowx)+x, (viewwindowy)+(viewheight), patch);
+	V_DrawPatch((viewwindowx)+x, (viewwindowy)+(scaledviewheight), patch);
     patch = W_CacheLumpName(DEH_String("brdr_l"),PU_CACHE);
 
-    for (y=0 ; y<(viewheight) ; y+=8)
+    for (y=0 ; y<(scaledviewheight) ; y+=8)
 	V_DrawPatch((viewwindowx)-8, (viewwindowy)+y, patch);
     patch = W_CacheLumpName(DEH_String("brdr_r"),PU_CACHE);
 
-    for (y=0 ; y<(viewheight) ; y+=8)
+    for (y=0 ; y<(scaledviewheight) ; y+=8)
 	V_DrawPatch((viewwindowx)+(scaledviewwidth), (viewwindowy)+y, patch);
 
     // Draw beveled edge. 
@@ -936,11 +1530,11 @@ void R_FillBackScreen (void)
                 W_CacheLumpName(DEH_String("brdr_tr"),PU_CACHE));
     
     V_DrawPatch((viewwindowx)-8,
-                (viewwindowy)+(viewheight),
+                (viewwindowy)+(scaledviewheight),
                 W_CacheLumpName(DEH_String("brdr_bl"),PU_CACHE));
     
     V_DrawPatch((viewwindowx)+(scaledviewwidth),
-                (viewwindowy)+(viewheight),
+                (viewwindowy)+(scaledviewheight),
                 W_CacheLumpName(DEH_String("brdr_br"),PU_CACHE));
 
     V_RestoreBuffer();
@@ -983,21 +1577,21 @@ void R_DrawViewBorder (void)
     if (scaledviewwidth == SCREENWIDTH) 
 	return; 
   
-    top = ((SCREENHEIGHT-SBARHEIGHT)-viewheight)/2;
+    top = ((SCREENHEIGHT-SBARHEIGHT)-scaledviewheight)/2;
     side = (SCREENWIDTH-scaledviewwidth)/2; 
  
     // copy top and one line of left side 
     R_VideoErase (0, top*SCREENWIDTH+side); 
  
     // copy one line of right side and bottom 
-    ofs = (viewheight+top)*SCREENWIDTH-side;
+    ofs = (scaledviewheight+top)*SCREENWIDTH-side;
     R_VideoErase (ofs, top*SCREENWIDTH+side); 
  
     // copy sides using wraparound 
     ofs = top*SCREENWIDTH + SCREENWIDTH-side; 
     side <<= 1;
     
-    for (i=1 ; i<viewheight ; i++)
+    for (i=1 ; i<scaledviewheight ; i++)
     { 
 	R_VideoErase (ofs, side); 
 	ofs += SCREENWIDTH; 
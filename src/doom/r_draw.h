@@ -23,17 +23,17 @@
 
 
 
-extern lighttable_t*	dc_colormap[2];
-extern int		dc_x;
-extern int		dc_yl;
-extern int		dc_yh;
-extern fixed_t		dc_iscale;
-extern fixed_t		dc_texturemid;
-extern int		dc_texheight;
-extern byte*		dc_brightmap;
+extern THREADLOCAL lighttable_t*	dc_colormap[2];
+extern THREADLOCAL int		dc_x;
+extern THREADLOCAL int		dc_yl;
+extern THREADLOCAL int		dc_yh;
+extern THREADLOCAL fixed_t		dc_iscale;
+extern THREADLOCAL fixed_t		dc_texturemid;
+extern THREADLOCAL int		dc_texheight;
+extern THREADLOCAL byte*		dc_brightmap;
 
 // first pixel in a column
-extern byte*		dc_source;		
+extern THREADLOCAL byte*		dc_source;		
 
 
 // The span blitting interface.
@@ -42,6 +42,26 @@ extern byte*		dc_source;
 void 	R_DrawColumn (void);
 void 	R_DrawColumnLow (void);
 
+// [crispy] adjacent wall columns, queued by R_BatchColumn()
+#define COLBATCH	4
+
+typedef struct
+{
+    int			num;
+    int			x;	// of the first column
+    lighttable_t*	colormap[2];
+    byte*		brightmap;
+    int			texheight;
+    int			yl[COLBATCH];
+    int			yh[COLBATCH];
+    fixed_t		iscale[COLBATCH];
+    fixed_t		texturemid[COLBATCH];
+    byte*		source[COLBATCH];
+} colbatch_t;
+
+void	R_BatchColumn (colbatch_t *batch);
+void	R_FlushColumns (colbatch_t *batch);
+
 // The Spectre/Invisibility effect.
 void 	R_DrawFuzzColumn (void);
 void 	R_DrawFuzzColumnLow (void);
@@ -64,23 +84,27 @@ R_VideoErase
 ( unsigned	ofs,
   int		count );
 
-extern int		ds_y;
-extern int		ds_x1;
-extern int		ds_x2;
+extern THREADLOCAL int		ds_y;
+extern THREADLOCAL int		ds_x1;
+extern THREADLOCAL int		ds_x2;
 
-extern lighttable_t*	ds_colormap[2];
-extern byte*		ds_brightmap;
+extern THREADLOCAL lighttable_t*	ds_colormap[2];
+extern THREADLOCAL byte*		ds_brightmap;
 
-extern fixed_t		ds_xfrac;
-extern fixed_t		ds_yfrac;
-extern fixed_t		ds_xstep;
-extern fixed_t		ds_ystep;
+extern THREADLOCAL fixed_t		ds_xfrac;
+extern THREADLOCAL fixed_t		ds_yfrac;
+extern THREADLOCAL fixed_t		ds_xstep;
+extern THREADLOCAL fixed_t		ds_ystep;
 
 // start of a 64*64 tile image
-extern byte*		ds_source;		
+extern THREADLOCAL byte*		ds_source;		
+
+// [crispy] LOD level of ds_source for R_DrawSpanLOD(),
+// which makes it a (64>>ds_lod)*(64>>ds_lod) tile
+extern THREADLOCAL int			ds_lod;
 
 extern byte*		translationtables;
-extern byte*		dc_translation;
+extern THREADLOCAL byte*		dc_translation;
 
 
 // Span blitting for rows, floor/ceiling.
@@ -90,12 +114,33 @@ void 	R_DrawSpan (void);
 // Low resolution mode, 160x200?
 void 	R_DrawSpanLow (void);
 
+// [crispy] the same for flat LOD levels
+void	R_DrawSpanLOD (void);
+void	R_DrawSpanLowLOD (void);
+
+// Span drawers picked by R_InitSpanFuncs(), vectorized if available.
+extern void	(*hispanfunc) (void);
+extern void	(*lospanfunc) (void);
+
+void	R_InitSpanFuncs (void);
+
+// [crispy] overdraw heatmap, see render_heatmap
+void	R_DrawColumnHeat (void);
+void	R_DrawSpanHeat (void);
+void	R_DrawHeatmap (void);
+
 
 void
 R_InitBuffer
 ( int		width,
   int		height );
 
+void	R_ScaleView (void);
+
+// Framebuffer address of each view row and column.
+extern pixel_t*		ylookup[MAXHEIGHT];
+extern int		columnofs[MAXWIDTH];
+
 
 // Initialize color translation tables,
 //  for player rendering etc.
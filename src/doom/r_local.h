@@ -56,5 +56,6 @@ extern lighttable_t*** cm_zlight;
 #include "r_data.h"
 #include "r_things.h"
 #include "r_draw.h"
+#include "r_pvs.h"
 
 #endif		// __R_LOCAL__
@@ -22,9 +22,14 @@
 
 
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
 
 #include "doomdef.h"
 #include "doomstat.h" // [AM] leveltime, paused, menuactive
@@ -34,6 +39,9 @@
 #include "m_menu.h"
 
 #include "i_system.h" // [crispy] I_Realloc()
+#include "i_thread.h"
+#include "i_timer.h" // [crispy] I_GetTimeUS()
+#include "m_argv.h"
 #include "p_local.h" // [crispy] MLOOKUNIT
 #include "r_local.h"
 #include "r_sky.h"
@@ -54,7 +62,7 @@ int			validcount = 1;
 
 
 lighttable_t*		fixedcolormap;
-extern lighttable_t**	walllights;
+extern THREADLOCAL lighttable_t**	walllights;
 
 int			centerx;
 int			centery;
@@ -66,7 +74,7 @@ fixed_t			projection;
 // just for profiling purposes
 int			framecount;	
 
-int			sscount;
+THREADLOCAL int			sscount;
 int			linecount;
 int			loopcount;
 
@@ -84,6 +92,36 @@ player_t*		viewplayer;
 // 0 = high, 1 = low
 int			detailshift;	
 
+// Strip rendering: the view is split into numrenderstrips vertical
+// strips, each rendered by its own thread into its own copy of the
+// THREADLOCAL renderer state. Every strip walks the whole BSP so that
+// clipping is the same as with a single thread, but only draws the
+// columns stripx1..stripx2.
+int			render_threads = 1;
+int			numrenderstrips = 1;
+THREADLOCAL int		stripnum;
+THREADLOCAL int		stripx1;
+THREADLOCAL int		stripx2;
+
+// Render scale: the view is rendered at render_scale percent of the
+// view window and scaled to fit, see R_InitBuffer().  With
+// render_governor set, R_GovernFrame() lowers renderscale, and
+// finally the detail, while frames take longer than a tic.
+int			render_scale = 100;
+int			render_governor = 0;
+static int		renderscale = 100;
+static boolean		governordetail = false;
+
+// Renderer statistics: the renderer counts into rstats, which every
+// strip hands over to stripstats[] when it is done, and
+// R_GatherStats() adds them up into renderstats.  With render_heatmap
+// set, the view shows how often each pixel was written instead.
+int			render_stats = 0;
+int			render_heatmap = 0;
+renderstats_t		renderstats;
+THREADLOCAL renderstats_t	rstats;
+static renderstats_t	stripstats[MAXTHREADS];
+
 //
 // precalculated math tables
 //
@@ -124,7 +162,7 @@ int MAXLIGHTZ;
 int LIGHTZSHIFT;
 
 
-void (*colfunc) (void);
+THREADLOCAL void (*colfunc) (void);
 void (*basecolfunc) (void);
 void (*fuzzcolfunc) (void);
 void (*transcolfunc) (void);
@@ -739,7 +777,9 @@ void R_InitLightTables (void)
 	LIGHTZSHIFT = 20;
     // }
 
-    scalelight = malloc(LIGHTLEVELS * sizeof(*scalelight));
+    // [crispy] the rows are made by R_ExecuteSetViewSize(), on the
+    // first call only
+    scalelight = calloc(LIGHTLEVELS, sizeof(*scalelight));
     scalelightfixed = malloc(MAXLIGHTSCALE * sizeof(*scalelightfixed));
     zlight = malloc(numcolormaps * sizeof(*zlight));
 
@@ -812,16 +852,20 @@ void R_ExecuteSetViewSize (void)
     if (setblocks >= 11) // [crispy] Crispy HUD
     {
 	scaledviewwidth = SCREENWIDTH;
-	viewheight = SCREENHEIGHT;
+	scaledviewheight = SCREENHEIGHT;
     }
     else
     {
 	scaledviewwidth = (setblocks*32);//<<crispy->hires;
-	viewheight = ((setblocks*168/10)&~7);//<<crispy->hires;
+	scaledviewheight = ((setblocks*168/10)&~7);//<<crispy->hires;
     }
+
+    // [crispy] render scale, kept even for the low detail drawers
+    renderwidth = (scaledviewwidth*renderscale/100)&~1;
+    viewheight = scaledviewheight*renderscale/100;
     
-    detailshift = setdetail;
-    viewwidth = scaledviewwidth>>detailshift;
+    detailshift = setdetail | governordetail;
+    viewwidth = renderwidth>>detailshift;
 	
     centery = viewheight/2;
     centerx = viewwidth/2;
@@ -829,13 +873,21 @@ void R_ExecuteSetViewSize (void)
     centeryfrac = centery<<FRACBITS;
     projection = centerxfrac;
 
-    if (!detailshift)
+    if (render_heatmap)
+    {
+	colfunc = basecolfunc = R_DrawColumnHeat;
+	fuzzcolfunc = R_DrawColumnHeat;
+	transcolfunc = R_DrawColumnHeat;
+	tlcolfunc = R_DrawColumnHeat;
+	spanfunc = R_DrawSpanHeat;
+    }
+    else if (!detailshift)
     {
 	colfunc = basecolfunc = R_DrawColumn;
 	fuzzcolfunc = R_DrawFuzzColumn;
 	transcolfunc = R_DrawTranslatedColumn;
 	tlcolfunc = R_DrawTLColumn;
-	spanfunc = R_DrawSpan;
+	spanfunc = hispanfunc;
     }
     else
     {
@@ -843,10 +895,10 @@ void R_ExecuteSetViewSize (void)
 	fuzzcolfunc = R_DrawFuzzColumnLow;
 	transcolfunc = R_DrawTranslatedColumnLow;
 	tlcolfunc = R_DrawTLColumnLow;
-	spanfunc = R_DrawSpanLow;
+	spanfunc = lospanfunc;
     }
 
-    R_InitBuffer (scaledviewwidth, viewheight);
+    R_InitBuffer (scaledviewwidth, scaledviewheight);
 	
     R_InitTextureMapping ();
     
@@ -883,7 +935,9 @@ void R_ExecuteSetViewSize (void)
     //  for each level / scale combination.
     for (i=0 ; i< LIGHTLEVELS ; i++)
     {
-	scalelight[i] = malloc(MAXLIGHTSCALE * sizeof(**scalelight));
+	// [crispy] reused, as the governor changes the size at runtime
+	if (!scalelight[i])
+	    scalelight[i] = malloc(MAXLIGHTSCALE * sizeof(**scalelight));
 
 	startmap = ((LIGHTLEVELS-LIGHTBRIGHT-i)*2)*NUMCOLORMAPS/LIGHTLEVELS;
 	for (j=0 ; j<MAXLIGHTSCALE ; j++)
@@ -911,6 +965,8 @@ void R_ExecuteSetViewSize (void)
 
 void R_Init (void)
 {
+    int i;
+
     R_InitData ();
     R_InitPointToAngle ();
     R_InitTables ();
@@ -921,8 +977,88 @@ void R_Init (void)
     R_InitLightTables ();
     R_InitSkyMap ();
     R_InitTranslationTables ();
+    R_InitSpanFuncs ();
 	
     framecount = 0;
+
+    //!
+    // @arg <n>
+    // @category video
+    //
+    // Render the view with n threads, each drawing a vertical strip
+    // of the screen.
+    //
+
+    i = M_CheckParmWithArgs("-rthreads", 1);
+
+    if (i)
+	render_threads = atoi(myargv[i+1]);
+
+    numrenderstrips = I_InitThreads(render_threads);
+
+    //!
+    // @arg <percent>
+    // @category video
+    //
+    // Render the view at the given percentage (50-200) of its size
+    // and scale it to fit.
+    //
+
+    i = M_CheckParmWithArgs("-rscale", 1);
+
+    if (i)
+	render_scale = atoi(myargv[i+1]);
+
+    render_scale = BETWEEN(MINRENDERSCALE, MAXRENDERSCALE, render_scale);
+    renderscale = render_scale;
+}
+
+//
+// R_GovernFrame
+// Called with the time each frame took to run and draw.  Every second
+// the average is checked against the length of a tic: the render
+// scale goes down in steps, and then the detail, while frames are
+// slower, and back up while they take less than half of it.
+//
+void R_GovernFrame (int frametime)
+{
+    static int	frametimes = 0;
+    static int	numframes = 0;
+    int		average;
+
+    if (!render_governor)
+	return;
+
+    frametimes += frametime;
+
+    if (++numframes < TICRATE)
+	return;
+
+    average = frametimes / numframes;
+    frametimes = numframes = 0;
+
+    if (average > 1000 / TICRATE)
+    {
+	if (renderscale > MINRENDERSCALE)
+	    renderscale = MAX(renderscale - 10, MINRENDERSCALE);
+	else if (!governordetail)
+	    governordetail = true;
+	else
+	    return;
+    }
+    else if (average < 1000 / TICRATE / 2)
+    {
+	if (governordetail)
+	    governordetail = false;
+	else if (renderscale < render_scale)
+	    renderscale = MIN(renderscale + 10, render_scale);
+	else
+	    return;
+    }
+    else
+	return;
+
+    setsizeneeded = true;
 }
 
 
@@ -966,10 +1102,29 @@ void R_SetupFrame (player_t* player)
     
     viewplayer = player;
 
-    viewx = player->mo->x;
-    viewy = player->mo->y;
-    viewz = player->viewz;
-    viewangle = player->mo->angle + viewangleoffset;
+    // [AM] Interpolate the player camera if the feature is enabled.
+    if (uncapped &&
+        // Don't interpolate on the first tic of a level,
+        // otherwise oldviewz might be garbage.
+        leveltime > 1 &&
+        // Don't interpolate if the player did something
+        // that would necessitate turning it off for a tic.
+        player->mo->interp &&
+        // Don't interpolate during a paused state
+        leveltime > oldleveltime)
+    {
+        viewx = player->mo->oldx + FixedMul(player->mo->x - player->mo->oldx, fractionaltic);
+        viewy = player->mo->oldy + FixedMul(player->mo->y - player->mo->oldy, fractionaltic);
+        viewz = player->oldviewz + FixedMul(player->viewz - player->oldviewz, fractionaltic);
+        viewangle = R_InterpolateAngle(player->mo->oldangle, player->mo->angle, fractionaltic) + viewangleoffset;
+    }
+    else
+    {
+        viewx = player->mo->x;
+        viewy = player->mo->y;
+        viewz = player->viewz;
+        viewangle = player->mo->angle + viewangleoffset;
+    }
 
     extralight = player->extralight;
 
@@ -999,6 +1154,11 @@ void R_SetupFrame (player_t* player)
         cm = 0;
 
     fullcolormap = colormaps[cm];
+
+    // [crispy] potentially visible sets, the view point may be outside
+    // of the map while walking through walls
+    R_SetupPVS(player->cheats & CF_NOCLIP ? NULL :
+               R_PointInSubsector(viewx, viewy)->sector);
     cm_zlight = zlight[0];
 
     sscount = 0;
@@ -1023,16 +1183,137 @@ void R_SetupFrame (player_t* player)
 
 
 
+//
+// R_StatsTime
+// Phase times are only taken while they are shown.
+//
+static inline uint64_t R_StatsTime (void)
+{
+    return render_stats ? I_GetTimeUS() : 0;
+}
+
+//
+// R_GatherStats
+// Adds up the statistics of the strips, the phase times are those of
+//  the slowest strip.  With render_stats set, they are sent to the page
+//  as an "R_RenderStats" event, or printed on native builds, once a
+//  second.
+//
+static void R_GatherStats (void)
+{
+    static int frames = 0;
+    renderstats_t *rs = &renderstats;
+    int i;
+
+    memset(rs, 0, sizeof(*rs));
+
+    for (i = 0; i < numrenderstrips; i++)
+    {
+	const renderstats_t *ss = &stripstats[i];
+
+	rs->visplanes += ss->visplanes;
+	rs->drawsegs += ss->drawsegs;
+	rs->vissprites += ss->vissprites;
+	rs->nodes += ss->nodes;
+	rs->culled += ss->culled;
+	rs->earlyouts += ss->earlyouts;
+	rs->columns += ss->columns;
+	rs->spans += ss->spans;
+	rs->pixels += ss->pixels;
+	rs->bsptime = MAX(rs->bsptime, ss->bsptime);
+	rs->planetime = MAX(rs->planetime, ss->planetime);
+	rs->maskedtime = MAX(rs->maskedtime, ss->maskedtime);
+    }
+
+    if (!render_stats || ++frames < TICRATE)
+	return;
+
+    frames = 0;
+
+#ifdef __EMSCRIPTEN__
+    EM_ASM_({
+        document.dispatchEvent(new CustomEvent("R_RenderStats", { detail: {
+            visplanes: $0, drawsegs: $1, vissprites: $2,
+            nodes: $3, culled: $4, earlyouts: $5,
+            columns: $6, spans: $7, pixels: $8,
+            bsptime: $9, planetime: $10, maskedtime: $11 } }));
+    }, rs->visplanes, rs->drawsegs, rs->vissprites,
+       rs->nodes, rs->culled, rs->earlyouts,
+       rs->columns, rs->spans, rs->pixels,
+       rs->bsptime, rs->planetime, rs->maskedtime);
+#else
+    printf("R_RenderStats: %d visplanes, %d drawsegs, %d vissprites, "
+           "%d nodes, %d culled, %d early-outs, "
+           "%d columns, %d spans, %d pixels, "
+           "bsp %d us, planes %d us, masked %d us\n",
+           rs->visplanes, rs->drawsegs, rs->vissprites,
+           rs->nodes, rs->culled, rs->earlyouts,
+           rs->columns, rs->spans, rs->pixels,
+           rs->bsptime, rs->planetime, rs->maskedtime);
+#endif
+}
+
+//
+// R_RenderStrip
+// Render the columns of one strip of the view,
+//  called on its own thread for each strip.
+//
+static void R_RenderStrip (int strip)
+{
+    uint64_t time;
+
+    stripnum = strip;
+    stripx1 = viewwidth * strip / numrenderstrips;
+    stripx2 = viewwidth * (strip + 1) / numrenderstrips - 1;
+
+    // set up the private copies of the state R_SetupFrame()
+    // and R_ExecuteSetViewSize() leave for the renderer
+    colfunc = basecolfunc;
+    if (fixedcolormap)
+	walllights = scalelightfixed;
+    sscount = 0;
+
+    R_ClearClipSegs ();
+    R_ClearDrawSegs ();
+    R_ClearPlanes ();
+    R_ClearSprites ();
+    memset(&rstats, 0, sizeof(rstats));
+
+    time = R_StatsTime();
+    R_RenderBSPNode (numnodes-1);
+    rstats.drawsegs = ds_p - drawsegs;
+    rstats.vissprites = vissprite_p - vissprites;
+    rstats.bsptime = (int) (R_StatsTime() - time);
+
+    time = R_StatsTime();
+    R_DrawPlanes ();
+    rstats.planetime = (int) (R_StatsTime() - time);
+
+    // [crispy] draw fuzz effect independent of rendering frame rate
+    time = R_StatsTime();
+    R_SetFuzzPosDraw();
+    R_DrawMasked ();
+    rstats.maskedtime = (int) (R_StatsTime() - time);
+
+    stripstats[strip] = rstats;
+}
+
+
 //
 // R_RenderView
 //
 void R_RenderPlayerView (player_t* player)
 {	
-    extern void V_DrawFilledBox (int x, int y, int w, int h, int c);
     extern void R_InterpolateTextureOffsets (void);
+    int i;
+    uint64_t time;
 
     R_SetupFrame (player);
 
+    stripnum = 0;
+    stripx1 = 0;
+    stripx2 = viewwidth - 1;
+
     // Clear buffers.
     R_ClearClipSegs ();
     R_ClearDrawSegs ();
@@ -1045,28 +1326,70 @@ void R_RenderPlayerView (player_t* player)
     }
     
     // [crispy] flashing HOM indicator
-    V_DrawFilledBox(viewwindowx, viewwindowy,
-        scaledviewwidth, viewheight, 0);
+    for (i = 0; i < viewheight; i++)
+	memset(ylookup[i] + columnofs[0], 0, renderwidth);
 
     // check for new console commands.
     NetUpdate ();
 
     // [crispy] smooth texture scrolling
     R_InterpolateTextureOffsets();
+
+    if (numrenderstrips > 1)
+    {
+	// the strips share the sectors, so do not leave
+	// R_MaybeInterpolateSector() anything to write
+	for (i = 0; i < numsectors; i++)
+	    R_MaybeInterpolateSector(&sectors[i]);
+
+	I_RunJobs(R_RenderStrip, numrenderstrips);
+
+	R_ReleaseFrameCache ();
+	R_GatherStats ();
+
+	if (render_heatmap)
+	    R_DrawHeatmap ();
+
+	R_ScaleView ();
+
+	// Check for new console commands.
+	NetUpdate ();
+	return;
+    }
+
+    memset(&rstats, 0, sizeof(rstats));
+
     // The head node is the last node output.
+    time = R_StatsTime();
     R_RenderBSPNode (numnodes-1);
+    rstats.drawsegs = ds_p - drawsegs;
+    rstats.vissprites = vissprite_p - vissprites;
+    rstats.bsptime = (int) (R_StatsTime() - time);
     
     // Check for new console commands.
     NetUpdate ();
     
+    time = R_StatsTime();
     R_DrawPlanes ();
+    rstats.planetime = (int) (R_StatsTime() - time);
     
     // Check for new console commands.
     NetUpdate ();
     
     // [crispy] draw fuzz effect independent of rendering frame rate
+    time = R_StatsTime();
     R_SetFuzzPosDraw();
     R_DrawMasked ();
+    rstats.maskedtime = (int) (R_StatsTime() - time);
+
+    stripstats[0] = rstats;
+    R_ReleaseFrameCache ();
+    R_GatherStats ();
+
+    if (render_heatmap)
+	R_DrawHeatmap ();
+
+    R_ScaleView ();
 
     // Check for new console commands.
     NetUpdate ();				
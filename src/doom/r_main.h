@@ -89,12 +89,49 @@ extern fixed_t          fractionaltic;
 //  0 = high, 1 = low
 extern	int		detailshift;	
 
+// Strip rendering, see R_RenderPlayerView().
+extern int		render_threads;
+extern int		numrenderstrips;
+extern THREADLOCAL int	stripnum;
+extern THREADLOCAL int	stripx1;
+extern THREADLOCAL int	stripx2;
+
+// Render scale in percent, see R_GovernFrame().
+#define MINRENDERSCALE	50
+#define MAXRENDERSCALE	200
+
+extern int		render_scale;
+extern int		render_governor;
+
+// [crispy] renderer statistics, see R_GatherStats()
+typedef struct
+{
+    int		visplanes;
+    int		drawsegs;
+    int		vissprites;
+    int		nodes;		// BSP nodes visited
+    int		culled;		// node boxes hidden by solid walls
+    int		earlyouts;	// subtrees skipped with the view covered
+    int		columns;
+    int		spans;
+    int		pixels;
+    // in microseconds
+    int		bsptime;
+    int		planetime;
+    int		maskedtime;
+} renderstats_t;
+
+extern int		render_stats;
+extern int		render_heatmap;
+extern renderstats_t	renderstats;
+extern THREADLOCAL renderstats_t	rstats;
+
 
 //
 // Function pointers to switch refresh/drawing functions.
 // Used to select shadow mode etc.
 //
-extern void		(*colfunc) (void);
+extern THREADLOCAL void		(*colfunc) (void);
 extern void		(*transcolfunc) (void);
 extern void		(*basecolfunc) (void);
 extern void		(*fuzzcolfunc) (void);
@@ -170,4 +207,7 @@ void R_Init (void);
 // Called by M_Responder.
 void R_SetViewSize (int blocks, int detail);
 
+// Called by D_DoomLoopIter.
+void R_GovernFrame (int frametime);
+
 #endif
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 
 #include "i_system.h"
+#include "i_thread.h"
 #include "z_zone.h"
 #include "w_wad.h"
 
@@ -42,17 +43,40 @@ planefunction_t		ceilingfunc;
 //
 
 // Here comes the obnoxious "visplane".
-#define MAXVISPLANES	128
-visplane_t*		visplanes = NULL;
-visplane_t*		lastvisplane;
-visplane_t*		floorplane;
-visplane_t*		ceilingplane;
-static int		numvisplanes;
+// [crispy] visplanes are hashed on (height, picnum, lightlevel)
+// and carved out of a frame arena, adapted from mbfsrc/R_PLANE.C
+#define MAXVISPLANES	128	// must be a power of 2
+#define visplane_hash(picnum,lightlevel,height) \
+  (((unsigned)(picnum)*3+(unsigned)(lightlevel)+(unsigned)(height)*7) & (MAXVISPLANES-1))
+
+static THREADLOCAL visplane_t*	visplanes[MAXVISPLANES];
+THREADLOCAL visplane_t*		floorplane;
+THREADLOCAL visplane_t*		ceilingplane;
+
+// [crispy] the frame arena is a chain of blocks that is rewound
+// at the start of every frame and only ever grows
+typedef struct planeblock_s
+{
+    struct planeblock_s	*next;
+    size_t		size;
+    size_t		used;
+} planeblock_t;
+
+#define PLANEBLOCKHEADER	((sizeof(planeblock_t) + 7) & ~(size_t)7)
+
+static THREADLOCAL planeblock_t*	planeblocks;
+static THREADLOCAL planeblock_t*	curplaneblock;
+
+// [crispy] per-frame visplane counters
+THREADLOCAL int			numvisplanes;
+THREADLOCAL int			visplaneprobes;
+THREADLOCAL int			visplaneclears;
+THREADLOCAL int			planearenasize;
 
 // ?
 #define MAXOPENINGS	MAXWIDTH*64*4
-int			openings[MAXOPENINGS]; // [crispy] 32-bit integer math
-int*			lastopening; // [crispy] 32-bit integer math
+THREADLOCAL int			openings[MAXOPENINGS]; // [crispy] 32-bit integer math
+THREADLOCAL int*			lastopening; // [crispy] 32-bit integer math
 
 
 //
@@ -60,32 +84,36 @@ int*			lastopening; // [crispy] 32-bit integer math
 //  floorclip starts out SCREENHEIGHT
 //  ceilingclip starts out -1
 //
-int			floorclip[MAXWIDTH]; // [crispy] 32-bit integer math
-int			ceilingclip[MAXWIDTH]; // [crispy] 32-bit integer math
+THREADLOCAL int			floorclip[MAXWIDTH]; // [crispy] 32-bit integer math
+THREADLOCAL int			ceilingclip[MAXWIDTH]; // [crispy] 32-bit integer math
 
 //
 // spanstart holds the start of a plane span
 // initialized to 0 at start
 //
-int			spanstart[MAXHEIGHT];
-int			spanstop[MAXHEIGHT];
+THREADLOCAL int			spanstart[MAXHEIGHT];
+THREADLOCAL int			spanstop[MAXHEIGHT];
 
 //
 // texture mapping
 //
-lighttable_t**		planezlight;
-fixed_t			planeheight;
+THREADLOCAL lighttable_t**		planezlight;
+THREADLOCAL fixed_t			planeheight;
+
+// [crispy] flat of the plane and its source, for the LOD levels
+static THREADLOCAL int			planeflat;
+static THREADLOCAL byte*		planesource;
 
 fixed_t*			yslope;
 fixed_t			yslopes[LOOKDIRS][MAXHEIGHT];
 fixed_t			distscale[MAXWIDTH];
-fixed_t			basexscale;
-fixed_t			baseyscale;
+THREADLOCAL fixed_t			basexscale;
+THREADLOCAL fixed_t			baseyscale;
 
-fixed_t			cachedheight[MAXHEIGHT];
-fixed_t			cacheddistance[MAXHEIGHT];
-fixed_t			cachedxstep[MAXHEIGHT];
-fixed_t			cachedystep[MAXHEIGHT];
+THREADLOCAL fixed_t			cachedheight[MAXHEIGHT];
+THREADLOCAL fixed_t			cacheddistance[MAXHEIGHT];
+THREADLOCAL fixed_t			cachedxstep[MAXHEIGHT];
+THREADLOCAL fixed_t			cachedystep[MAXHEIGHT];
 
 
 
@@ -177,8 +205,27 @@ R_MapPlane
     ds_x1 = x1;
     ds_x2 = x2;
 
-    // high or low detail
-    spanfunc ();	
+    rstats.spans++;
+    rstats.pixels += (x2 - x1 + 1) << detailshift;
+
+    // [crispy] draw distant spans from a flat LOD level
+    if (planeflat >= 0 && !render_heatmap &&
+        (ds_lod = R_FlatLOD(MAX(abs(ds_xstep), abs(ds_ystep)))))
+    {
+	ds_source = R_GetFlatLOD(planeflat, ds_lod);
+
+	if (detailshift)
+	    R_DrawSpanLowLOD ();
+	else
+	    R_DrawSpanLOD ();
+    }
+    else
+    {
+	ds_source = planesource;
+
+	// high or low detail
+	spanfunc ();
+    }
 }
 
 
@@ -198,7 +245,16 @@ void R_ClearPlanes (void)
 	ceilingclip[i] = -1;
     }
 
-    lastvisplane = visplanes;
+    // [crispy] empty the hash chains and rewind the frame arena
+    memset (visplanes, 0, sizeof(visplanes));
+    curplaneblock = planeblocks;
+    if (curplaneblock)
+	curplaneblock->used = PLANEBLOCKHEADER;
+
+    numvisplanes = 0;
+    visplaneprobes = 0;
+    visplaneclears = 0;
+
     lastopening = openings;
     
     // texture calculation
@@ -214,28 +270,90 @@ void R_ClearPlanes (void)
 
 
 
-// [crispy] remove MAXVISPLANES Vanilla limit
-static void R_RaiseVisplanes (visplane_t** vp)
+// [crispy] carve a new visplane and its top[]/bottom[] arrays out of
+// the frame arena, sized to the current viewwidth
+static visplane_t *R_NewVisplane (unsigned hash)
 {
-    if (lastvisplane - visplanes == numvisplanes)
+    const size_t size = (sizeof(visplane_t) + 2 * (viewwidth + 2) * sizeof(unsigned int) + 7) & ~(size_t)7;
+    visplane_t *check;
+
+    while (!curplaneblock || curplaneblock->used + size > curplaneblock->size)
     {
-	int numvisplanes_old = numvisplanes;
-	visplane_t* visplanes_old = visplanes;
+	if (curplaneblock && curplaneblock->next)
+	{
+	    curplaneblock = curplaneblock->next;
+	}
+	else
+	{
+	    // [crispy] remove MAXVISPLANES Vanilla limit
+	    const size_t blocksize = PLANEBLOCKHEADER + MAXVISPLANES * size;
+	    planeblock_t *block = Z_Malloc(blocksize, PU_STATIC, NULL);
+
+	    block->next = NULL;
+	    block->size = blocksize;
 
-	numvisplanes = numvisplanes ? 2 * numvisplanes : MAXVISPLANES;
-	visplanes = I_Realloc(visplanes, numvisplanes * sizeof(*visplanes));
-	memset(visplanes + numvisplanes_old, 0, (numvisplanes - numvisplanes_old) * sizeof(*visplanes));
+	    if (curplaneblock)
+	    {
+		curplaneblock->next = block;
+		fprintf(stderr, "R_FindPlane: Hit %d visplanes, frame arena raised to %d bytes.\n", numvisplanes, planearenasize + (int) blocksize);
+	    }
+	    else
+		planeblocks = block;
+
+	    curplaneblock = block;
+	    planearenasize += blocksize;
+	}
 
-	lastvisplane = visplanes + numvisplanes_old;
-	floorplane = visplanes + (floorplane - visplanes_old);
-	ceilingplane = visplanes + (ceilingplane - visplanes_old);
+	curplaneblock->used = PLANEBLOCKHEADER;
+    }
+
+    check = (visplane_t *) ((byte *) curplaneblock + curplaneblock->used);
+    curplaneblock->used += size;
+
+    check->top = (unsigned int *) (check + 1) + 1;
+    check->bottom = check->top + viewwidth + 2;
 
-	if (numvisplanes_old)
-	    fprintf(stderr, "R_FindPlane: Hit MAXVISPLANES limit at %d, raised to %d.\n", numvisplanes_old, numvisplanes);
+    check->next = visplanes[hash];
+    visplanes[hash] = check;
+    numvisplanes++;
+
+    return check;
+}
 
-	// keep the pointer passed as argument in relation to the visplanes pointer
-	if (vp)
-	    *vp = visplanes + (*vp - visplanes_old);
+// [crispy] lazily clear top[] and bottom[] for the columns a visplane
+// is about to grow by, instead of clearing all of it whenever a visplane
+// is made. Arena memory is recycled, so bottom[] must never be left at
+// 0xffffffff where top[] is unset, or R_MakeSpans() would run away.
+static void R_ClearPlaneRange (visplane_t *pl, int start, int stop)
+{
+    if (start <= stop)
+    {
+	memset (pl->top + start, 0xff, (stop - start + 1) * sizeof(*pl->top));
+	memset (pl->bottom + start, 0, (stop - start + 1) * sizeof(*pl->bottom));
+	visplaneclears += stop - start + 1;
+    }
+}
+
+static void R_GrowPlane (visplane_t *pl, int start, int stop)
+{
+    if (pl->minx > pl->maxx)
+    {
+	R_ClearPlaneRange(pl, start, stop);
+	pl->minx = start;
+	pl->maxx = stop;
+	return;
+    }
+
+    if (start < pl->minx)
+    {
+	R_ClearPlaneRange(pl, start, pl->minx - 1);
+	pl->minx = start;
+    }
+
+    if (stop > pl->maxx)
+    {
+	R_ClearPlaneRange(pl, pl->maxx + 1, stop);
+	pl->maxx = stop;
     }
 }
 
@@ -249,6 +367,7 @@ R_FindPlane
   int		lightlevel )
 {
     visplane_t*	check;
+    unsigned	hash;
 	
     // [crispy] add support for MBF sky tranfers
     if (picnum == skyflatnum || picnum & PL_SKYFLAT)
@@ -256,34 +375,28 @@ R_FindPlane
 	height = 0;			// all skys map together
 	lightlevel = 0;
     }
+
+    hash = visplane_hash(picnum, lightlevel, height);
 	
-    for (check=visplanes; check<lastvisplane; check++)
+    for (check=visplanes[hash]; check; check=check->next)
     {
+	visplaneprobes++;
+
 	if (height == check->height
 	    && picnum == check->picnum
 	    && lightlevel == check->lightlevel)
 	{
-	    break;
+	    return check;
 	}
     }
     
-			
-    if (check < lastvisplane)
-	return check;
-		
-    R_RaiseVisplanes(&check); // [crispy] remove VISPLANES limit
-    if (lastvisplane - visplanes == MAXVISPLANES && false)
-	I_Error ("R_FindPlane: no more visplanes");
-		
-    lastvisplane++;
+    check = R_NewVisplane(hash);
 
     check->height = height;
     check->picnum = picnum;
     check->lightlevel = lightlevel;
-    check->minx = SCREENWIDTH;
+    check->minx = MAXWIDTH;
     check->maxx = -1;
-    
-    memset (check->top,0xff,sizeof(check->top));
 		
     return check;
 }
@@ -300,31 +413,17 @@ R_CheckPlane
 {
     int		intrl;
     int		intrh;
-    int		unionl;
-    int		unionh;
     int		x;
 	
     if (start < pl->minx)
-    {
 	intrl = pl->minx;
-	unionl = start;
-    }
     else
-    {
-	unionl = pl->minx;
 	intrl = start;
-    }
 	
     if (stop > pl->maxx)
-    {
 	intrh = pl->maxx;
-	unionh = stop;
-    }
     else
-    {
-	unionh = pl->maxx;
 	intrh = stop;
-    }
 
     for (x=intrl ; x<= intrh ; x++)
 	if (pl->top[x] != 0xffffffffu) // [crispy] hires / 32-bit integer math
@@ -336,8 +435,7 @@ R_CheckPlane
   {
     if (x > intrh)
     {
-	pl->minx = unionl;
-	pl->maxx = unionh;
+	R_GrowPlane(pl, start, stop);
 
 	// use the same one
 	return pl;		
@@ -345,19 +443,19 @@ R_CheckPlane
   }
 	
     // make a new visplane
-    R_RaiseVisplanes(&pl); // [crispy] remove VISPLANES limit
-    lastvisplane->height = pl->height;
-    lastvisplane->picnum = pl->picnum;
-    lastvisplane->lightlevel = pl->lightlevel;
-    
-    if (lastvisplane - visplanes == MAXVISPLANES && false) // [crispy] remove VISPLANES limit
-	I_Error ("R_CheckPlane: no more visplanes");
+    {
+	visplane_t *new_pl = R_NewVisplane(visplane_hash(pl->picnum, pl->lightlevel, pl->height));
 
-    pl = lastvisplane++;
-    pl->minx = start;
-    pl->maxx = stop;
+	new_pl->height = pl->height;
+	new_pl->picnum = pl->picnum;
+	new_pl->lightlevel = pl->lightlevel;
+	new_pl->minx = MAXWIDTH;
+	new_pl->maxx = -1;
+
+	pl = new_pl;
+    }
 
-    memset (pl->top,0xff,sizeof(pl->top));
+    R_GrowPlane(pl, start, stop);
 		
     return pl;
 }
@@ -399,7 +497,29 @@ R_MakeSpans
 
 // [crispy] add support for SMMU swirling flats
 // adapted from smmu/r_ripple.c, by Simon Howard
-static char *R_DistortedFlat (int flatnum)
+
+// The sines advance by multiples of 8192/1024 per tic,
+// so the swirl repeats every SWIRLPERIOD tics.
+#define SWIRLPERIOD 1024
+
+typedef struct
+{
+    int		tic;
+    byte	pixels[4096];
+} distortedflat_t;
+
+// distorted flats by flat number, shared by the strip threads
+// and only touched with the cache lock held
+static distortedflat_t **distortedflats;
+static int swirltic = -1;
+static short swirloffset[4096];
+
+//
+// R_SwirlOffsets
+// Each axis of the swirl is the sum of a row term and a column term,
+// so the offset table is put together from four 64-entry tables.
+//
+static void R_SwirlOffsets (int tic)
 {
     const int swirlfactor = 8192 / 64;
     const int swirlfactor2 = 8192 / 32;
@@ -407,56 +527,233 @@ static char *R_DistortedFlat (int flatnum)
     const int amp2 = 2;
     const int speed = 40;
 
-    static int swirltic;
-    static int offset[4096];
+    int rowx[64], colx[64], coly[64], rowy[64];
+    int x, y;
 
-    static char distortedflat[4096];
-    char *normalflat;
-    int i;
+    tic &= SWIRLPERIOD - 1;
 
-    if (swirltic != gametic)
+    for (x = 0; x < 64; x++)
     {
-	int x, y;
+	rowx[x] = (finesine[(x * swirlfactor + tic * speed * 5 + 900) & 8191] * amp) >> FRACBITS;
+	colx[x] = (finesine[(x * swirlfactor2 + tic * speed * 4 + 300) & 8191] * amp2) >> FRACBITS;
+	coly[x] = (finesine[(x * swirlfactor + tic * speed * 3 + 700) & 8191] * amp) >> FRACBITS;
+	rowy[x] = (finesine[(x * swirlfactor2 + tic * speed * 4 + 1200) & 8191] * amp2) >> FRACBITS;
+    }
 
+    for (y = 0; y < 64; y++)
+    {
 	for (x = 0; x < 64; x++)
 	{
-	    for (y = 0; y < 64; y++)
-	    {
-		int x1, y1;
-		int sinvalue, sinvalue2;
+	    const int x1 = (x + 128 + rowx[y] + colx[x]) & 63;
+	    const int y1 = (y + 128 + coly[x] + rowy[y]) & 63;
+
+	    swirloffset[(y << 6) + x] = (y1 << 6) + x1;
+	}
+    }
+}
 
-		sinvalue = (y * swirlfactor + leveltime * speed * 5 + 900) & 8191;
-		sinvalue2 = (x * swirlfactor2 + leveltime * speed * 4 + 300) & 8191;
-		x1 = x + 128
-		   + ((finesine[sinvalue] * amp) >> FRACBITS)
-		   + ((finesine[sinvalue2] * amp2) >> FRACBITS);
+//
+// R_DistortedFlat
+// Returns the flat swirled for the current tic, distorting it
+// only the first time it is asked for in the tic.
+//
+static byte *R_DistortedFlat (int flatnum)
+{
+    distortedflat_t *flat;
+    byte *normalflat;
+    int i;
 
-		sinvalue = (x * swirlfactor + leveltime * speed * 3 + 700) & 8191;
-		sinvalue2 = (y * swirlfactor2 + leveltime * speed * 4 + 1200) & 8191;
-		y1 = y + 128
-		   + ((finesine[sinvalue] * amp) >> FRACBITS)
-		   + ((finesine[sinvalue2] * amp2) >> FRACBITS);
+    if (distortedflats == NULL)
+    {
+	distortedflats = Z_Malloc(numflats * sizeof(*distortedflats), PU_STATIC, 0);
+	memset(distortedflats, 0, numflats * sizeof(*distortedflats));
+    }
 
-		x1 &= 63;
-		y1 &= 63;
+    flat = distortedflats[flatnum - firstflat];
 
-		offset[(y << 6) + x] = (y1 << 6) + x1;
-	    }
+    if (flat == NULL)
+    {
+	flat = Z_Malloc(sizeof(*flat), PU_STATIC, 0);
+	flat->tic = -1;
+	distortedflats[flatnum - firstflat] = flat;
+    }
+
+    if (flat->tic != leveltime)
+    {
+	if (swirltic != leveltime)
+	{
+	    R_SwirlOffsets(leveltime);
+	    swirltic = leveltime;
+	}
+
+	normalflat = R_CacheLumpForFrame(flatnum);
+
+	for (i = 0; i < 4096; i++)
+	{
+	    flat->pixels[i] = normalflat[swirloffset[i]];
 	}
 
-	swirltic = gametic;
+	flat->tic = leveltime;
     }
 
-    normalflat = W_CacheLumpNum(flatnum, PU_STATIC);
+    return flat->pixels;
+}
+
+// [crispy] Sky panoramas: the sky texture mapped to the rows of the view
+// and through the colormap once, so that drawing a sky column is a plain
+// copy.  The columns are built as they come into view, and the panorama
+// is started over when the texture, its offset, the view size, the
+// detail or the colormap change.
+
+#define MAXSKYPANORAMAS 4
 
-    for (i = 0; i < 4096; i++)
+typedef struct
+{
+    int			texture;
+    fixed_t		texturemid;
+    fixed_t		iscale;
+    int			centery;
+    int			height;
+    lighttable_t*	colormap;
+    boolean		lowdetail;
+    int			width;
+    byte*		built;
+    pixel_t*		pixels;
+} skypanorama_t;
+
+static THREADLOCAL skypanorama_t skypanoramas[MAXSKYPANORAMAS];
+static THREADLOCAL int nextskypanorama;
+
+//
+// R_SkyPanorama
+// Returns the panorama of the texture for dc_texturemid, dc_iscale
+//  and dc_colormap, recycling the oldest one if there is none yet.
+//
+static skypanorama_t *R_SkyPanorama (int texture)
+{
+    const boolean lowdetail = (detailshift != 0);
+    skypanorama_t *sky;
+    int i;
+
+    for (i = 0; i < MAXSKYPANORAMAS; i++)
     {
-	distortedflat[i] = normalflat[offset[i]];
+	sky = &skypanoramas[i];
+
+	if (sky->pixels &&
+	    sky->texture == texture &&
+	    sky->texturemid == dc_texturemid &&
+	    sky->iscale == dc_iscale &&
+	    sky->centery == centery &&
+	    sky->height == viewheight &&
+	    sky->colormap == dc_colormap[0] &&
+	    sky->lowdetail == lowdetail)
+	{
+	    return sky;
+	}
     }
 
-    Z_ChangeTag(normalflat, PU_CACHE);
+    sky = &skypanoramas[nextskypanorama];
+    nextskypanorama = (nextskypanorama + 1) % MAXSKYPANORAMAS;
+
+    sky->texture = texture;
+    sky->texturemid = dc_texturemid;
+    sky->iscale = dc_iscale;
+    sky->centery = centery;
+    sky->height = viewheight;
+    sky->colormap = dc_colormap[0];
+    sky->lowdetail = lowdetail;
+    sky->width = texturewidthmask[texture] + 1;
 
-    return distortedflat;
+    sky->pixels = I_Realloc(sky->pixels, sky->width * sky->height * sizeof(*sky->pixels));
+    sky->built = I_Realloc(sky->built, sky->width * sizeof(*sky->built));
+    memset(sky->built, 0, sky->width * sizeof(*sky->built));
+
+    return sky;
+}
+
+//
+// R_SkyColumn
+// Returns one column of the panorama, building it first if needed.
+//  Every pixel comes out as R_DrawColumn() or R_DrawColumnLow()
+//  would have drawn it.
+//
+static const pixel_t *R_SkyColumn (skypanorama_t *sky, int col)
+{
+    pixel_t *dest;
+
+    col &= sky->width - 1;
+    dest = sky->pixels + col * sky->height;
+
+    if (!sky->built[col])
+    {
+	const byte *source = R_GetColumn(sky->texture, col, false);
+	const lighttable_t *colormap = R_FusedColormap(dc_colormap, dc_brightmap,
+	                                               sky->lowdetail ? NULL : fullcolormap);
+	const int heightmask = dc_texheight - 1;
+	const fixed_t height = dc_texheight << FRACBITS;
+	int y;
+
+	for (y = 0; y < sky->height; y++)
+	{
+	    fixed_t frac = sky->texturemid + (y - sky->centery) * sky->iscale;
+
+	    // [crispy] Tutti-Frutti fix
+	    if (dc_texheight & heightmask)
+	    {
+		frac %= height;
+
+		if (frac < 0)
+		    frac += height;
+
+		dest[y] = colormap[source[frac >> FRACBITS]];
+	    }
+	    else
+	    {
+		dest[y] = colormap[source[(frac >> FRACBITS) & heightmask]];
+	    }
+	}
+
+	sky->built[col] = true;
+    }
+
+    return dest;
+}
+
+//
+// R_DrawSkyColumn
+// Copies rows dc_yl to dc_yh of a panorama column to column dc_x.
+//
+static void R_DrawSkyColumn (const pixel_t *source, boolean lowdetail)
+{
+    int count = dc_yh - dc_yl;
+    pixel_t *dest;
+
+    source += dc_yl;
+
+    if (lowdetail)
+    {
+	pixel_t *dest2;
+
+	dest = ylookup[dc_yl] + columnofs[dc_x << 1];
+	dest2 = ylookup[dc_yl] + columnofs[(dc_x << 1) + 1];
+
+	do
+	{
+	    *dest = *dest2 = *source++;
+	    dest += renderpitch;
+	    dest2 += renderpitch;
+	} while (count--);
+    }
+    else
+    {
+	dest = ylookup[dc_yl] + columnofs[dc_x];
+
+	do
+	{
+	    *dest = *source++;
+	    dest += renderpitch;
+	} while (count--);
+    }
 }
 
 
@@ -472,34 +769,42 @@ void R_DrawPlanes (void)
     int			stop;
     int			angle;
     int                 lumpnum;
+    int                 i;
+    byte*               arenaflat;
 				
 #ifdef RANGECHECK
     if (ds_p - drawsegs > numdrawsegs)
 	I_Error ("R_DrawPlanes: drawsegs overflow (%" PRIiPTR ")",
 		 (unsigned int)(ds_p - drawsegs));
     
-    if (lastvisplane - visplanes > numvisplanes)
-	I_Error ("R_DrawPlanes: visplane overflow (%" PRIiPTR ")",
-		 (unsigned int)(lastvisplane - visplanes));
-    
     if (lastopening - openings > MAXOPENINGS)
 	I_Error ("R_DrawPlanes: opening overflow (%" PRIiPTR ")",
 		 (unsigned int)(lastopening - openings));
 #endif
 
-    for (pl = visplanes ; pl < lastvisplane ; pl++)
+    for (i = 0 ; i < MAXVISPLANES ; i++)
+    for (pl = visplanes[i] ; pl ; pl = pl->next)
     {
 	const boolean swirling = (flattranslation[pl->picnum] == -1);
 
+	// only draw the columns of this strip
+	if (pl->minx < stripx1)
+	    pl->minx = stripx1;
+	if (pl->maxx > stripx2)
+	    pl->maxx = stripx2;
+
 	if (pl->minx > pl->maxx)
 	    continue;
 
+	rstats.visplanes++;
+
 	
 	// sky flat
 	// [crispy] add support for MBF sky tranfers
 	if (pl->picnum == skyflatnum || pl->picnum & PL_SKYFLAT)
 	{
 	    int texture;
+	    skypanorama_t *sky;
 	    angle_t an = viewangle, flip;
 	    if (pl->picnum & PL_SKYFLAT)
 	    {
@@ -526,6 +831,7 @@ void R_DrawPlanes (void)
 	    // [crispy] no brightmaps for sky
 	    dc_colormap[0] = dc_colormap[1] = fullcolormap;
 	    dc_texheight = textureheight[texture]>>FRACBITS; // [crispy] Tutti-Frutti fix
+	    sky = R_SkyPanorama(texture);
 	    
 	    for (x=pl->minx ; x <= pl->maxx ; x++)
 	    {
@@ -536,8 +842,13 @@ void R_DrawPlanes (void)
 		{
 		    angle = ((an + xtoviewangle[x])^flip)>>ANGLETOSKYSHIFT;
 		    dc_x = x;
-		    dc_source = R_GetColumn(texture, angle, false);
-		    colfunc ();
+		    rstats.columns++;
+		    rstats.pixels += (dc_yh - dc_yl + 1) << detailshift;
+
+		    if (render_heatmap)
+			colfunc();
+		    else
+			R_DrawSkyColumn(R_SkyColumn(sky, angle), sky->lowdetail);
 		}
 	    }
 	    continue;
@@ -546,7 +857,21 @@ void R_DrawPlanes (void)
 	// regular flat
         lumpnum = firstflat + (swirling ? pl->picnum : flattranslation[pl->picnum]);
 	// [crispy] add support for SMMU swirling flats
-	ds_source = swirling ? R_DistortedFlat(lumpnum) : W_CacheLumpNum(lumpnum, PU_STATIC);
+	// [crispy] flats of the level come from the texture arena
+	arenaflat = swirling ? NULL : arenaflats ? arenaflats[lumpnum - firstflat] : NULL;
+
+	if (arenaflat)
+	{
+	    ds_source = arenaflat;
+	}
+	else
+	{
+	    I_LockCache();
+	    ds_source = swirling ? R_DistortedFlat(lumpnum) : R_CacheLumpForFrame(lumpnum);
+	    I_UnlockCache();
+	}
+	planesource = ds_source;
+	planeflat = swirling ? -1 : lumpnum - firstflat;
 	ds_brightmap = R_BrightmapForFlatNum(lumpnum-firstflat);
 	
 	planeheight = abs(pl->height-viewz);
@@ -562,6 +887,8 @@ void R_DrawPlanes (void)
 
 	pl->top[pl->maxx+1] = 0xffffffffu; // [crispy] hires / 32-bit integer math
 	pl->top[pl->minx-1] = 0xffffffffu; // [crispy] hires / 32-bit integer math
+	pl->bottom[pl->maxx+1] = 0; // [crispy] pads come from the frame arena
+	pl->bottom[pl->minx-1] = 0;
 		
 	stop = pl->maxx + 1;
 
@@ -572,7 +899,5 @@ void R_DrawPlanes (void)
 			pl->top[x],
 			pl->bottom[x]);
 	}
-	
-        W_ReleaseLumpNum(lumpnum);
     }
 }
\ No newline at end of file
@@ -0,0 +1,645 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Potentially visible sets of the sectors.
+//
+//	For every sector there is a bit for each sector that a line
+//	of sight out of it may reach.  The sets are found by following
+//	the two-sided lines ("openings") from sector to sector in the
+//	plane, for as long as some line through all the openings passed
+//	so far still reaches the next one.  Heights are never looked at,
+//	so whatever a door or a lift may open up is always in the set.
+//
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "z_zone.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_misc.h"
+#include "sha1.h"
+#include "w_wad.h"
+
+#include "doomdata.h"
+#include "doomstat.h"
+
+#include "r_local.h"
+#include "r_pvs.h"
+#include "r_state.h"
+
+
+#define PVS_MAXBYTES	(16 << 20)	// larger maps go without
+#define PVS_MAXSTEPS	65536		// per sector, it sees all beyond that
+#define PVS_FRAMETIME	2		// ms of each frame spent making the sets
+#define PVS_EPSILON	(1.0 / 1024)
+#define PVS_SLACK	8.0		// map units added to both ends of openings
+#define PVS_VERSION	2		// of the sets kept in files
+
+typedef struct
+{
+    double	x, y;		// from the first vertex of the line
+    double	dx, dy;
+    int		line;
+    int		sector;		// on the far side
+} pvsportal_t;
+
+typedef struct
+{
+    int		portal;
+    double	u1, u2;		// the part of it in view, 0 to 1
+} pvsflow_t;
+
+typedef struct
+{
+    int		stamp;
+    double	u1, u2;
+} pvsseen_t;
+
+int		render_pvs = 1;
+
+byte*		pvsnodes;
+byte*		pvssubsectors;
+
+static byte*		pvs;
+static int		pvsrowbytes;
+static byte*		nodevis;
+static byte*		subsectorvis;
+static sector_t*	pvsviewsector;
+
+static pvsportal_t*	portals;
+static int*		firstportal;
+static int		numportals;
+
+static pvsflow_t*	flows;
+static int		numflows;
+static int		maxflows;
+
+static pvsseen_t*	seen;
+static int		seenstamp;
+
+// the sets being made, a few sectors each frame
+static boolean		pvsbuilding;
+static int		pvsnextsector;
+static int		pvssize;
+static char*		pvsfilename;
+
+
+static inline void R_MarkSector (byte *row, int sec)
+{
+    row[sec >> 3] |= 1 << (sec & 7);
+}
+
+static inline boolean R_SectorInRow (const byte *row, int sec)
+{
+    return (row[sec >> 3] & (1 << (sec & 7))) != 0;
+}
+
+
+//
+// R_MakePortals
+// Every two-sided line between two different sectors is an opening
+// out of each of them.  The openings are made a little longer than
+// the lines, as the renderer clips to fixed point angles and whole
+// columns and may see a little past the end of a line.
+//
+static void R_MakePortals (void)
+{
+    int *fill;
+    int i, side;
+
+    firstportal = Z_Malloc((numsectors + 1) * sizeof(*firstportal), PU_STATIC, NULL);
+    memset(firstportal, 0, (numsectors + 1) * sizeof(*firstportal));
+
+    for (i = 0; i < numlines; i++)
+    {
+	const line_t *ld = &lines[i];
+
+	if (ld->backsector && ld->backsector != ld->frontsector)
+	{
+	    firstportal[ld->frontsector - sectors + 1]++;
+	    firstportal[ld->backsector - sectors + 1]++;
+	}
+    }
+
+    for (i = 0; i < numsectors; i++)
+	firstportal[i + 1] += firstportal[i];
+
+    numportals = firstportal[numsectors];
+    portals = Z_Malloc(MAX(numportals, 1) * sizeof(*portals), PU_STATIC, NULL);
+
+    fill = Z_Malloc(numsectors * sizeof(*fill), PU_STATIC, NULL);
+    memcpy(fill, firstportal, numsectors * sizeof(*fill));
+
+    for (i = 0; i < numlines; i++)
+    {
+	const line_t *ld = &lines[i];
+	const sector_t *from[2] = {ld->frontsector, ld->backsector};
+	const double dx = (double) ld->dx / FRACUNIT;
+	const double dy = (double) ld->dy / FRACUNIT;
+	const double len = sqrt(dx * dx + dy * dy);
+	const double slack = len > 0.0 ? PVS_SLACK / len : 0.0;
+
+	if (!ld->backsector || ld->backsector == ld->frontsector)
+	    continue;
+
+	for (side = 0; side < 2; side++)
+	{
+	    pvsportal_t *p = &portals[fill[from[side] - sectors]++];
+
+	    p->x = (double) ld->v1->x / FRACUNIT - slack * dx;
+	    p->y = (double) ld->v1->y / FRACUNIT - slack * dy;
+	    p->dx = (1.0 + 2.0 * slack) * dx;
+	    p->dy = (1.0 + 2.0 * slack) * dy;
+	    p->line = i;
+	    p->sector = from[side ^ 1] - sectors;
+	}
+    }
+
+    Z_Free(fill);
+}
+
+static int R_CompareBounds (const void *a, const void *b)
+{
+    const int64_t x = *(const int64_t *) a;
+    const int64_t y = *(const int64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+//
+// R_LineInSector
+// True if the middle of the line lies within the lines that bound
+// the sector, by counting the bounds crossed on the way to the right.
+//
+static boolean R_LineInSector (const line_t *ld, const sector_t *sec)
+{
+    const double mx = ((double) ld->v1->x + ld->v2->x) / (2 * FRACUNIT);
+    const double my = ((double) ld->v1->y + ld->v2->y) / (2 * FRACUNIT);
+    boolean inside = false;
+    int i;
+
+    for (i = 0; i < sec->linecount; i++)
+    {
+	const line_t *bound = sec->lines[i];
+	const double x1 = (double) bound->v1->x / FRACUNIT;
+	const double y1 = (double) bound->v1->y / FRACUNIT;
+	const double x2 = (double) bound->v2->x / FRACUNIT;
+	const double y2 = (double) bound->v2->y / FRACUNIT;
+
+	if (bound->frontsector == bound->backsector || (y1 > my) == (y2 > my))
+	    continue;
+
+	if (mx < x1 + (my - y1) * (x2 - x1) / (y2 - y1))
+	    inside = !inside;
+    }
+
+    return inside;
+}
+
+//
+// R_SectorsClosed
+// True if the sectors are bounded the way the sets take them to be:
+// every sector by closed loops of its lines, and every subsector by
+// the sides of its own sector only, with the lines that have it on
+// both sides inside of it.  Trick sectors (self-referencing lines,
+// missing lines) can be seen into across lines that are not
+// openings, so such maps go without sets.
+//
+static boolean R_SectorsClosed (void)
+{
+    int64_t*	bounds;
+    int		numbounds = 0;
+    boolean	closed = true;
+    int		i, j;
+
+    for (i = 0; i < numsubsectors; i++)
+    {
+	const subsector_t *ss = &subsectors[i];
+
+	for (j = 0; j < ss->numlines; j++)
+	    if (segs[ss->firstline + j].frontsector != ss->sector)
+		return false;
+    }
+
+    bounds = Z_Malloc(MAX(numlines, 1) * 4 * sizeof(*bounds), PU_STATIC, NULL);
+
+    for (i = 0; i < numlines; i++)
+    {
+	const line_t *ld = &lines[i];
+	const sector_t *from[2] = {ld->frontsector, ld->backsector};
+
+	if (ld->frontsector == ld->backsector)
+	{
+	    // a grate in the middle of a room, not the edge of a
+	    // deep water or invisible bridge sector
+	    if (!R_LineInSector(ld, ld->frontsector))
+	    {
+		Z_Free(bounds);
+		return false;
+	    }
+
+	    continue;
+	}
+
+	for (j = 0; j < 2; j++)
+	{
+	    if (!from[j])
+		continue;
+
+	    bounds[numbounds++] = ((int64_t) (from[j] - sectors) << 32)
+	                        | (ld->v1 - vertexes);
+	    bounds[numbounds++] = ((int64_t) (from[j] - sectors) << 32)
+	                        | (ld->v2 - vertexes);
+	}
+    }
+
+    // every corner of a sector must be shared by an even number of
+    // its bounding lines
+    qsort(bounds, numbounds, sizeof(*bounds), R_CompareBounds);
+
+    for (i = 0; i < numbounds && closed; i = j)
+    {
+	for (j = i + 1; j < numbounds && bounds[j] == bounds[i]; j++);
+
+	closed = !((j - i) & 1);
+    }
+
+    Z_Free(bounds);
+    return closed;
+}
+
+//
+// R_ClipPortal
+// Narrows the opening t down to the part that lines through the
+// opening s and the part u1..u2 of the opening p can reach.  Both
+// parameters of a line through the two vary monotonically, so the
+// part is spanned by the lines through their end points, unless one
+// of the lines in between runs parallel to t.  Then all of t is kept,
+// as it is when in doubt: the sets only ever get larger for it.
+//
+static boolean R_ClipPortal (const pvsportal_t *s, const pvsportal_t *p,
+                             double u1, double u2, const pvsportal_t *t,
+                             double *t1, double *t2)
+{
+    const double sx[2] = {s->x, s->x + s->dx};
+    const double sy[2] = {s->y, s->y + s->dy};
+    const double px[2] = {p->x + u1 * p->dx, p->x + u2 * p->dx};
+    const double py[2] = {p->y + u1 * p->dy, p->y + u2 * p->dy};
+    double lo = 1.0, hi = 0.0;
+    int sign = 0;
+    int i, j;
+
+    for (i = 0; i < 2; i++)
+	for (j = 0; j < 2; j++)
+	{
+	    const double lx = px[j] - sx[i];
+	    const double ly = py[j] - sy[i];
+	    const double den = lx * t->dy - ly * t->dx;
+	    double u;
+
+	    if (den == 0.0 || (sign && (den > 0.0) != (sign > 0)))
+	    {
+		*t1 = 0.0;
+		*t2 = 1.0;
+		return true;
+	    }
+
+	    sign = den > 0.0 ? 1 : -1;
+	    u = (lx * (sy[i] - t->y) - ly * (sx[i] - t->x)) / den;
+
+	    if (!i && !j)
+		lo = hi = u;
+	    else if (u < lo)
+		lo = u;
+	    else if (u > hi)
+		hi = u;
+	}
+
+    lo -= PVS_EPSILON;
+    hi += PVS_EPSILON;
+
+    if (hi < 0.0 || lo > 1.0)
+	return false;
+
+    *t1 = MAX(lo, 0.0);
+    *t2 = MIN(hi, 1.0);
+    return true;
+}
+
+//
+// R_PushFlow
+// Goes on through the part t1..t2 of an opening, unless that part
+// has already been followed since the last opening out of the source.
+// What was followed before is widened to take the new part in, which
+// keeps the number of passes through each opening small.
+//
+static boolean R_PushFlow (byte *row, int portal, double t1, double t2)
+{
+    pvsseen_t *ps = &seen[portal];
+
+    if (ps->stamp == seenstamp)
+    {
+	if (t1 >= ps->u1 && t2 <= ps->u2)
+	    return false;
+
+	t1 = MIN(t1, ps->u1);
+	t2 = MAX(t2, ps->u2);
+    }
+
+    ps->stamp = seenstamp;
+    ps->u1 = t1;
+    ps->u2 = t2;
+
+    R_MarkSector(row, portals[portal].sector);
+
+    if (numflows == maxflows)
+    {
+	maxflows = maxflows ? 2 * maxflows : 1024;
+	flows = I_Realloc(flows, maxflows * sizeof(*flows));
+    }
+
+    flows[numflows].portal = portal;
+    flows[numflows].u1 = t1;
+    flows[numflows].u2 = t2;
+    numflows++;
+
+    return true;
+}
+
+//
+// R_FlowSector
+// Fills in the row of the sector.  Anything beyond an opening out of
+// it is in view through that opening alone, from there on the part of
+// each further opening that is still in view is carried along.
+//
+static boolean R_FlowSector (int sec, byte *row)
+{
+    int steps = 0;
+    int i, t;
+
+    R_MarkSector(row, sec);
+
+    for (i = firstportal[sec]; i < firstportal[sec + 1]; i++)
+    {
+	const pvsportal_t *s = &portals[i];
+
+	seenstamp++;
+	R_MarkSector(row, s->sector);
+
+	for (t = firstportal[s->sector]; t < firstportal[s->sector + 1]; t++)
+	    if (portals[t].line != s->line)
+		R_PushFlow(row, t, 0.0, 1.0);
+
+	while (numflows)
+	{
+	    const pvsflow_t f = flows[--numflows];
+	    const pvsportal_t *p = &portals[f.portal];
+
+	    for (t = firstportal[p->sector]; t < firstportal[p->sector + 1]; t++)
+	    {
+		double t1, t2;
+
+		if (portals[t].line == p->line ||
+		    !R_ClipPortal(s, p, f.u1, f.u2, &portals[t], &t1, &t2))
+		    continue;
+
+		if (R_PushFlow(row, t, t1, t2) && ++steps > PVS_MAXSTEPS)
+		{
+		    numflows = 0;
+		    return false;
+		}
+	    }
+	}
+    }
+
+    return true;
+}
+
+//
+// R_PVSFileName
+// The sets are kept in a file named after the hash of the lumps
+// they are made from.
+//
+static char *R_PVSFileName (int lumpnum)
+{
+    const int maplumps[] = {ML_VERTEXES, ML_LINEDEFS, ML_SIDEDEFS};
+    sha1_context_t context;
+    sha1_digest_t digest;
+    char name[32];
+    int i;
+
+    SHA1_Init(&context);
+    SHA1_UpdateInt32(&context, PVS_VERSION);
+    SHA1_UpdateInt32(&context, numsectors);
+
+    for (i = 0; i < arrlen(maplumps); i++)
+    {
+	const int lump = lumpnum + maplumps[i];
+
+	SHA1_Update(&context, W_CacheLumpNum(lump, PU_STATIC), W_LumpLength(lump));
+	W_ReleaseLumpNum(lump);
+    }
+
+    SHA1_Final(digest, &context);
+
+    M_snprintf(name, sizeof(name), "pvs%02x%02x%02x%02x%02x%02x%02x%02x.dat",
+               digest[0], digest[1], digest[2], digest[3],
+               digest[4], digest[5], digest[6], digest[7]);
+
+    return M_StringJoin(savegamedir, name, NULL);
+}
+
+//
+// R_LoadPVS
+//
+static boolean R_LoadPVS (const char *filename, int size)
+{
+    byte *buffer;
+    int length;
+
+    if (!M_FileExists(filename))
+	return false;
+
+    length = M_ReadFile(filename, &buffer);
+
+    if (length == size)
+	memcpy(pvs, buffer, size);
+
+    Z_Free(buffer);
+
+    return length == size;
+}
+
+//
+// R_FreePVSBuild
+// Drops what is only needed while the sets are made.
+//
+static void R_FreePVSBuild (void)
+{
+    if (!pvsbuilding)
+	return;
+
+    Z_Free(seen);
+    Z_Free(portals);
+    Z_Free(firstportal);
+    free(pvsfilename);
+    pvsfilename = NULL;
+    pvsbuilding = false;
+}
+
+//
+// R_BuildPVS
+// Called by P_SetupLevel() once the lines know their sectors.  The
+// sets are loaded if they have been made for the map before, and
+// made by R_ContinuePVS() and saved otherwise.  Maps with sectors
+// that are not closed get no sets, nor does any map without
+// render_pvs.
+//
+void R_BuildPVS (int lumpnum)
+{
+    pvsviewsector = NULL;
+
+    // the sets of the last map may still have been in the making
+    R_FreePVSBuild();
+
+    if (!render_pvs)
+	return;
+
+    pvsrowbytes = (numsectors + 7) / 8;
+    pvssize = numsectors * pvsrowbytes;
+
+    if (pvssize > PVS_MAXBYTES)
+    {
+	fprintf(stderr, "R_BuildPVS: %d sectors are too many.\n", numsectors);
+	return;
+    }
+
+    if (!R_SectorsClosed())
+	return;
+
+    Z_Malloc(MAX(pvssize, 1), PU_LEVEL, &pvs);
+
+    pvsfilename = R_PVSFileName(lumpnum);
+
+    if (R_LoadPVS(pvsfilename, pvssize))
+    {
+	free(pvsfilename);
+	pvsfilename = NULL;
+	return;
+    }
+
+    memset(pvs, 0, pvssize);
+
+    R_MakePortals();
+    seen = Z_Malloc(MAX(numportals, 1) * sizeof(*seen), PU_STATIC, NULL);
+    memset(seen, 0, MAX(numportals, 1) * sizeof(*seen));
+    seenstamp = 0;
+
+    pvsnextsector = 0;
+    pvsbuilding = true;
+}
+
+//
+// R_ContinuePVS
+// Makes the sets of as many sectors as fit into PVS_FRAMETIME, so the
+// first visit of a map does not stall.  A sector with too many
+// openings in view sees all of the map.  Once all are made, the sets
+// are saved.
+//
+static void R_ContinuePVS (void)
+{
+    const int time = I_GetTimeMS();
+
+    while (pvsnextsector < numsectors && I_GetTimeMS() - time < PVS_FRAMETIME)
+    {
+	byte *row = pvs + pvsnextsector * pvsrowbytes;
+
+	if (!R_FlowSector(pvsnextsector, row))
+	    memset(row, 0xff, pvsrowbytes);
+
+	pvsnextsector++;
+    }
+
+    if (pvsnextsector == numsectors)
+    {
+	M_WriteFile(pvsfilename, pvs, pvssize);
+	R_FreePVSBuild();
+    }
+}
+
+//
+// R_MarkPVSNode
+// Marks the subtrees with a subsector in the row.
+//
+static boolean R_MarkPVSNode (int bspnum, const byte *row)
+{
+    const node_t *bsp;
+    boolean front, back;
+
+    if (bspnum & NF_SUBSECTOR)
+    {
+	const int num = bspnum == -1 ? 0 : bspnum & (~NF_SUBSECTOR);
+
+	subsectorvis[num] = R_SectorInRow(row, subsectors[num].sector - sectors);
+	return subsectorvis[num];
+    }
+
+    bsp = &nodes[bspnum];
+    front = R_MarkPVSNode(bsp->children[0], row);
+    back = R_MarkPVSNode(bsp->children[1], row);
+
+    nodevis[bspnum] = front || back;
+    return nodevis[bspnum];
+}
+
+//
+// R_SetupPVS
+// Called by R_SetupFrame() with the sector of the view point, or NULL
+// if it may lie outside of the map.  The BSP walk leaves out what is
+// not in the set, and with it the sprites of those subsectors.  Until
+// the sets are made, it walks all of the tree.
+//
+void R_SetupPVS (sector_t *viewsector)
+{
+    if (render_pvs && pvs && pvsbuilding)
+	R_ContinuePVS();
+
+    if (!render_pvs || !pvs || pvsbuilding || !viewsector)
+    {
+	pvsnodes = pvssubsectors = NULL;
+	return;
+    }
+
+    if (!nodevis)
+    {
+	Z_Malloc(MAX(numnodes, 1), PU_LEVEL, &nodevis);
+	Z_Malloc(numsubsectors, PU_LEVEL, &subsectorvis);
+	pvsviewsector = NULL;
+    }
+
+    if (viewsector != pvsviewsector)
+    {
+	R_MarkPVSNode(numnodes - 1,
+	              pvs + (viewsector - sectors) * pvsrowbytes);
+	pvsviewsector = viewsector;
+    }
+
+    pvsnodes = nodevis;
+    pvssubsectors = subsectorvis;
+}
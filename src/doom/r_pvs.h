@@ -0,0 +1,36 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Potentially visible sets of the sectors.
+//
+
+
+#ifndef __R_PVS__
+#define __R_PVS__
+
+#include "doomtype.h"
+#include "r_defs.h"
+
+extern int		render_pvs;
+
+// What can be seen from the view sector, set up by R_SetupPVS()
+// for the frame.  NULL without a PVS, the BSP walk is then exact.
+extern byte*		pvsnodes;
+extern byte*		pvssubsectors;
+
+void R_BuildPVS (int lumpnum);
+void R_SetupPVS (sector_t *viewsector);
+
+#endif
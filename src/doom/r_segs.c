@@ -37,56 +37,56 @@
 // OPTIMIZE: closed two sided lines as single sided
 
 // True if any of the segs textures might be visible.
-boolean		segtextured;	
+THREADLOCAL boolean		segtextured;	
 
 // False if the back side is the same plane.
-boolean		markfloor;	
-boolean		markceiling;
+THREADLOCAL boolean		markfloor;	
+THREADLOCAL boolean		markceiling;
 
-boolean		maskedtexture;
-int		toptexture;
-int		bottomtexture;
-int		midtexture;
+THREADLOCAL boolean		maskedtexture;
+THREADLOCAL int		toptexture;
+THREADLOCAL int		bottomtexture;
+THREADLOCAL int		midtexture;
 
 
-angle_t		rw_normalangle;
+THREADLOCAL angle_t		rw_normalangle;
 // angle to line origin
-int		rw_angle1;	
+THREADLOCAL int		rw_angle1;	
 
 //
 // regular wall
 //
-int		rw_x;
-int		rw_stopx;
-angle_t		rw_centerangle;
-fixed_t		rw_offset;
-fixed_t		rw_distance;
-fixed_t		rw_scale;
-fixed_t		rw_scalestep;
-fixed_t		rw_midtexturemid;
-fixed_t		rw_toptexturemid;
-fixed_t		rw_bottomtexturemid;
+THREADLOCAL int		rw_x;
+THREADLOCAL int		rw_stopx;
+THREADLOCAL angle_t		rw_centerangle;
+THREADLOCAL fixed_t		rw_offset;
+THREADLOCAL fixed_t		rw_distance;
+THREADLOCAL fixed_t		rw_scale;
+THREADLOCAL fixed_t		rw_scalestep;
+THREADLOCAL fixed_t		rw_midtexturemid;
+THREADLOCAL fixed_t		rw_toptexturemid;
+THREADLOCAL fixed_t		rw_bottomtexturemid;
 
-int		worldtop;
-int		worldbottom;
-int		worldhigh;
-int		worldlow;
+THREADLOCAL int		worldtop;
+THREADLOCAL int		worldbottom;
+THREADLOCAL int		worldhigh;
+THREADLOCAL int		worldlow;
 
-int64_t		pixhigh; // [crispy] WiggleFix
-int64_t		pixlow; // [crispy] WiggleFix
-fixed_t		pixhighstep;
-fixed_t		pixlowstep;
+THREADLOCAL int64_t		pixhigh; // [crispy] WiggleFix
+THREADLOCAL int64_t		pixlow; // [crispy] WiggleFix
+THREADLOCAL fixed_t		pixhighstep;
+THREADLOCAL fixed_t		pixlowstep;
 
-int64_t		topfrac; // [crispy] WiggleFix
-fixed_t		topstep;
+THREADLOCAL int64_t		topfrac; // [crispy] WiggleFix
+THREADLOCAL fixed_t		topstep;
 
-int64_t		bottomfrac; // [crispy] WiggleFix
-fixed_t		bottomstep;
+THREADLOCAL int64_t		bottomfrac; // [crispy] WiggleFix
+THREADLOCAL fixed_t		bottomstep;
 
 
-lighttable_t**	walllights;
+THREADLOCAL lighttable_t**	walllights;
 
-int*		maskedtexturecol; // [crispy] 32-bit integer math
+THREADLOCAL int*		maskedtexturecol; // [crispy] 32-bit integer math
 
 
 // [crispy] WiggleFix: add this code block near the top of r_segs.c
@@ -130,10 +130,10 @@ int*		maskedtexturecol; // [crispy] 32-bit integer math
 //   possibly, creating a noticable performance penalty.
 //
 
-static int	max_rwscale = 64 * FRACUNIT;
-static int	heightbits = 12;
-static int	heightunit = (1 << 12);
-static int	invhgtbits = 4;
+static THREADLOCAL int	max_rwscale = 64 * FRACUNIT;
+static THREADLOCAL int	heightbits = 12;
+static THREADLOCAL int	heightunit = (1 << 12);
+static THREADLOCAL int	invhgtbits = 4;
 
 static const struct
 {
@@ -152,8 +152,9 @@ static const struct
 
 void R_FixWiggle (sector_t *sector)
 {
-    static int	lastheight = 0;
+    static THREADLOCAL int	lastheight = 0;
     int		height = (sector->interpceilingheight - sector->interpfloorheight) >> FRACBITS;
+    int		scaleindex;
 
     // disallow negative heights. using 1 forces cache initialization
     if (height < 1)
@@ -167,18 +168,26 @@ void R_FixWiggle (sector_t *sector)
 	// initialize, or handle moving sector
 	if (height != sector->cachedheight)
 	{
-	    sector->cachedheight = height;
-	    sector->scaleindex = 0;
+	    scaleindex = 0;
 	    height >>= 7;
 
 	    // calculate adjustment
 	    while (height >>= 1)
-		sector->scaleindex++;
+		scaleindex++;
+
+	    // strip rendering threads must not race on the sector cache
+	    if (numrenderstrips == 1)
+	    {
+		sector->cachedheight = lastheight;
+		sector->scaleindex = scaleindex;
+	    }
 	}
+	else
+	    scaleindex = sector->scaleindex;
 
 	// fine-tune renderer for this wall
-	max_rwscale = scale_values[sector->scaleindex].clamp;
-	heightbits = scale_values[sector->scaleindex].heightbits;
+	max_rwscale = scale_values[scaleindex].clamp;
+	heightbits = scale_values[scaleindex].heightbits;
 	heightunit = (1 << heightbits);
 	invhgtbits = FRACBITS - heightbits;
     }
@@ -222,6 +231,12 @@ R_RenderMaskedSegRange
 
     maskedtexturecol = ds->maskedtexturecol;
 
+    // only draw the columns of this strip
+    if (x1 < stripx1)
+	x1 = stripx1;
+    if (x2 > stripx2)
+	x2 = stripx2;
+
     rw_scalestep = ds->scalestep;		
     spryscale = ds->scale1 + (x1 - ds->x1)*rw_scalestep;
     mfloorclip = ds->sprbottomclip;
@@ -279,7 +294,7 @@ R_RenderMaskedSegRange
 		             (int64_t) dc_texturemid * spryscale;
 
 		if (t + (int64_t) textureheight[texnum] * spryscale < 0 ||
-		    t > (int64_t) SCREENHEIGHT << FRACBITS*2)
+		    t > (int64_t) viewheight << FRACBITS*2)
 		{
 			spryscale += rw_scalestep; // [crispy] MBF had this in the for-loop iterator
 			continue; // skip if the texture is out of screen's range
@@ -316,6 +331,36 @@ R_RenderMaskedSegRange
 #define HEIGHTBITS		12
 #define HEIGHTUNIT		(1<<HEIGHTBITS)
 
+// [crispy] wall columns waiting to be drawn, per tier
+static THREADLOCAL colbatch_t midbatch, topbatch, bottombatch;
+
+//
+// R_WallColumn
+// [crispy] Sets up dc_source, dc_texturemid, dc_iscale and dc_texheight
+//  for a column of a wall tier, from the texture LOD level that suits
+//  the distance of the wall.
+//
+static inline void R_WallColumn (int texture, int texturecolumn,
+                                 fixed_t texturemid, fixed_t iscale)
+{
+    const int lod = R_TextureLOD(texture, iscale);
+
+    if (lod)
+    {
+	dc_source = R_GetColumnLOD(texture, lod, texturecolumn);
+	dc_texturemid = texturemid >> lod;
+	dc_iscale = (unsigned) iscale >> lod;
+	dc_texheight = (textureheight[texture]>>FRACBITS) >> lod;
+    }
+    else
+    {
+	dc_source = R_GetColumn(texture, texturecolumn, true);
+	dc_texturemid = texturemid;
+	dc_iscale = iscale;
+	dc_texheight = textureheight[texture]>>FRACBITS; // [crispy] Tutti-Frutti fix
+    }
+}
+
 void R_RenderSegLoop (void)
 {
     angle_t		angle;
@@ -324,11 +369,15 @@ void R_RenderSegLoop (void)
     int			yh;
     int			mid;
     fixed_t		texturecolumn;
+    fixed_t		iscale;
     int			top;
     int			bottom;
 
     for ( ; rw_x < rw_stopx ; rw_x++)
     {
+	// clipping is done for every column, drawing only in this strip
+	const boolean drawcol = rw_x >= stripx1 && rw_x <= stripx2;
+
 	// mark floor / ceiling areas
 	yl = (int)((topfrac+heightunit-1)>>heightbits); // [crispy] WiggleFix
 
@@ -386,26 +435,28 @@ void R_RenderSegLoop (void)
 	    dc_colormap[0] = walllights[index];
 		dc_colormap[1] = dc_colormap[0];
 	    dc_x = rw_x;
-	    dc_iscale = 0xffffffffu / (unsigned)rw_scale;
+	    iscale = 0xffffffffu / (unsigned)rw_scale;
 	}
         else
         {
             // purely to shut up the compiler
 
             texturecolumn = 0;
+            iscale = 0;
         }
 	
 	// draw the wall tiers
 	if (midtexture)
 	{
 	    // single sided line
-	    dc_yl = yl;
-	    dc_yh = yh;
-	    dc_texturemid = rw_midtexturemid;
-	    dc_source = R_GetColumn(midtexture,texturecolumn,true);
-	    dc_texheight = textureheight[midtexture]>>FRACBITS; // [crispy] Tutti-Frutti fix
-	    dc_brightmap = texturebrightmap[midtexture];
-	    colfunc ();
+	    if (drawcol)
+	    {
+		dc_yl = yl;
+		dc_yh = yh;
+		R_WallColumn(midtexture, texturecolumn, rw_midtexturemid, iscale);
+		dc_brightmap = texturebrightmap[midtexture];
+		R_BatchColumn (&midbatch);
+	    }
 	    ceilingclip[rw_x] = viewheight;
 	    floorclip[rw_x] = -1;
 	}
@@ -423,13 +474,14 @@ void R_RenderSegLoop (void)
 
 		if (mid >= yl)
 		{
-		    dc_yl = yl;
-		    dc_yh = mid;
-		    dc_texturemid = rw_toptexturemid;
-		    dc_source = R_GetColumn(toptexture,texturecolumn,true);
-		    dc_texheight = textureheight[toptexture]>>FRACBITS; // [crispy] Tutti-Frutti fix
-		    dc_brightmap = texturebrightmap[toptexture];
-		    colfunc ();
+		    if (drawcol)
+		    {
+			dc_yl = yl;
+			dc_yh = mid;
+			R_WallColumn(toptexture, texturecolumn, rw_toptexturemid, iscale);
+			dc_brightmap = texturebrightmap[toptexture];
+			R_BatchColumn (&topbatch);
+		    }
 		    ceilingclip[rw_x] = mid;
 		}
 		else
@@ -454,14 +506,14 @@ void R_RenderSegLoop (void)
 		
 		if (mid <= yh)
 		{
-		    dc_yl = mid;
-		    dc_yh = yh;
-		    dc_texturemid = rw_bottomtexturemid;
-		    dc_source = R_GetColumn(bottomtexture,
-					    texturecolumn,true);
-		    dc_texheight = textureheight[bottomtexture]>>FRACBITS; // [crispy] Tutti-Frutti fix
-		    dc_brightmap = texturebrightmap[bottomtexture];
-		    colfunc ();
+		    if (drawcol)
+		    {
+			dc_yl = mid;
+			dc_yh = yh;
+			R_WallColumn(bottomtexture, texturecolumn, rw_bottomtexturemid, iscale);
+			dc_brightmap = texturebrightmap[bottomtexture];
+			R_BatchColumn (&bottombatch);
+		    }
 		    floorclip[rw_x] = mid;
 		}
 		else
@@ -486,6 +538,10 @@ void R_RenderSegLoop (void)
 	topfrac += topstep;
 	bottomfrac += bottomstep;
     }
+
+    R_FlushColumns (&midbatch);
+    R_FlushColumns (&topbatch);
+    R_FlushColumns (&bottombatch);
 }
 
 
@@ -556,7 +612,9 @@ R_StoreWallRange
     linedef = curline->linedef;
 
     // mark the segment as visible for auto map
-    linedef->flags |= ML_MAPPED;
+    // (every strip sees the same segments, so leave it to the first)
+    if (!stripnum)
+	linedef->flags |= ML_MAPPED;
     
     // [crispy] (flags & ML_MAPPED) is all we need to know for automap
     if (automapactive /*&& !crispy->automapoverlay*/)
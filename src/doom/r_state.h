@@ -36,6 +36,7 @@
 
 // needed for texture pegging
 extern fixed_t*		textureheight;
+extern int*		texturewidthmask;
 
 // needed for pre rendering (fracs)
 extern fixed_t*		spritewidth;
@@ -47,9 +48,13 @@ extern lighttable_t	**colormaps;
 
 extern int		viewwidth;
 extern int		scaledviewwidth;
+extern int		scaledviewheight;
+extern int		renderwidth;
+extern int		renderpitch;
 extern int		viewheight;
 
 extern int		firstflat;
+extern int		numflats;
 
 // for global animation
 extern int*		flattranslation;	
@@ -108,19 +113,19 @@ extern angle_t		clipangle;
 extern int		viewangletox[FINEANGLES/2];
 extern angle_t		xtoviewangle[MAXWIDTH+1];
 
-extern fixed_t		rw_distance;
-extern angle_t		rw_normalangle;
+extern THREADLOCAL fixed_t		rw_distance;
+extern THREADLOCAL angle_t		rw_normalangle;
 
 
 
 // angle to line origin
-extern int		rw_angle1;
+extern THREADLOCAL int		rw_angle1;
 
 // Segs count?
-extern int		sscount;
+extern THREADLOCAL int		sscount;
 
-extern visplane_t*	floorplane;
-extern visplane_t*	ceilingplane;
+extern THREADLOCAL visplane_t*	floorplane;
+extern THREADLOCAL visplane_t*	ceilingplane;
 
 
 #endif
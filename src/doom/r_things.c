@@ -21,6 +21,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 #include "deh_main.h"
@@ -28,7 +29,9 @@
 
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_thread.h"
 #include "z_zone.h"
+#include "v_video.h" // [crispy] V_DecodePatchNum()
 #include "w_wad.h"
 
 #include "r_local.h"
@@ -78,12 +81,12 @@ laserpatch_t *laserpatch = laserpatch_m;
 fixed_t		pspritescale;
 fixed_t		pspriteiscale;
 
-lighttable_t**	spritelights;
+THREADLOCAL lighttable_t**	spritelights;
 
 // constant arrays
 //  used for psprite clipping and initializing clipping
-int		negonearray[SCREENWIDTH]; // [crispy] 32-bit integer math
-int		screenheightarray[SCREENWIDTH]; // [crispy] 32-bit integer math
+int		negonearray[MAXWIDTH]; // [crispy] 32-bit integer math
+int		screenheightarray[MAXWIDTH]; // [crispy] 32-bit integer math
 
 
 //
@@ -313,10 +316,19 @@ void R_InitSpriteDefs(const char **namelist)
 //
 // GAME FUNCTIONS
 //
-vissprite_t*	vissprites = NULL;
-vissprite_t*	vissprite_p;
-int		newvissprite;
-static int	numvissprites;
+THREADLOCAL vissprite_t*	vissprites = NULL;
+THREADLOCAL vissprite_t*	vissprite_p;
+THREADLOCAL int		newvissprite;
+static THREADLOCAL int	numvissprites;
+
+// [crispy] the vissprites in drawing order and the other
+// half of the radix sort, both sized with the vissprites[] pool
+static THREADLOCAL vissprite_t**	vsprsorted;
+static THREADLOCAL vissprite_t**	vsprscratch;
+
+// [crispy] sort key, the scale with the sign flipped to sort unsigned
+#define VISSPRITEKEY(vis, shift) \
+    ((((unsigned int) (vis)->scale ^ 0x80000000u) >> (shift)) & 0xff)
 
 
 
@@ -328,7 +340,7 @@ void R_InitSprites(const char **namelist)
 {
     int		i;
 	
-    for (i=0 ; i<SCREENWIDTH ; i++)
+    for (i=0 ; i<MAXWIDTH ; i++)
     {
 	negonearray[i] = -1;
     }
@@ -338,12 +350,46 @@ void R_InitSprites(const char **namelist)
 
 
 
+//
+// R_ReserveVisSprites
+// [crispy] Grow the vissprite pool and the sort buffers to hold
+//  at least count vissprites, up to the 4096 cap.
+//
+static void R_ReserveVisSprites (int count)
+{
+    const int numvissprites_old = numvissprites;
+    const int used = vissprite_p - vissprites;
+
+    if (count > 32 * MAXVISSPRITES)
+	count = 32 * MAXVISSPRITES;
+
+    if (count <= numvissprites)
+	return;
+
+    while (numvissprites < count)
+	numvissprites = numvissprites ? 2 * numvissprites : MAXVISSPRITES;
+
+    vissprites = I_Realloc(vissprites, numvissprites * sizeof(*vissprites));
+    memset(vissprites + numvissprites_old, 0, (numvissprites - numvissprites_old) * sizeof(*vissprites));
+
+    vsprsorted = I_Realloc(vsprsorted, numvissprites * sizeof(*vsprsorted));
+    vsprscratch = I_Realloc(vsprscratch, numvissprites * sizeof(*vsprscratch));
+
+    vissprite_p = vissprites + used;
+}
+
 //
 // R_ClearSprites
 // Called at frame start.
 //
 void R_ClearSprites (void)
 {
+    // [crispy] size the pool for the last frame and then some,
+    // so that it does not have to grow in the middle of the next
+    const int used = vissprite_p - vissprites;
+
+    R_ReserveVisSprites(used + used / 2);
+
     vissprite_p = vissprites;
 }
 
@@ -351,14 +397,14 @@ void R_ClearSprites (void)
 //
 // R_NewVisSprite
 //
-vissprite_t	overflowsprite;
+THREADLOCAL vissprite_t	overflowsprite;
 
 vissprite_t* R_NewVisSprite (void)
 {
     // [crispy] remove MAXVISSPRITE Vanilla limit
     if (vissprite_p == &vissprites[numvissprites])
     {
-	static int max;
+	static THREADLOCAL int max;
 	int numvissprites_old = numvissprites;
 
 	// [crispy] cap MAXVISSPRITES limit at 4096
@@ -371,11 +417,7 @@ vissprite_t* R_NewVisSprite (void)
 	if (max)
 	return &overflowsprite;
 
-	numvissprites = numvissprites ? 2 * numvissprites : MAXVISSPRITES;
-	vissprites = I_Realloc(vissprites, numvissprites * sizeof(*vissprites));
-	memset(vissprites + numvissprites_old, 0, (numvissprites - numvissprites_old) * sizeof(*vissprites));
-
-	vissprite_p = vissprites + numvissprites_old;
+	R_ReserveVisSprites(numvissprites + 1);
 
 	if (numvissprites_old)
 	    fprintf(stderr, "R_NewVisSprite: Hit MAXVISSPRITES limit at %d, raised to %d.\n", numvissprites_old, numvissprites);
@@ -393,16 +435,54 @@ vissprite_t* R_NewVisSprite (void)
 // Masked means: partly transparent, i.e. stored
 //  in posts/runs of opaque pixels.
 //
-int*		mfloorclip; // [crispy] 32-bit integer math
-int*		mceilingclip; // [crispy] 32-bit integer math
+THREADLOCAL int*		mfloorclip; // [crispy] 32-bit integer math
+THREADLOCAL int*		mceilingclip; // [crispy] 32-bit integer math
 
-fixed_t		spryscale;
-int64_t		sprtopscreen; // [crispy] WiggleFix
+THREADLOCAL fixed_t		spryscale;
+THREADLOCAL int64_t		sprtopscreen; // [crispy] WiggleFix
 
-void R_DrawMaskedColumn (column_t* column)
+//
+// R_DrawMaskedPost
+// Draws one post of length pixels, top pixels down the column.
+//
+static inline void R_DrawMaskedPost (int top, int length, byte *source,
+                                     fixed_t basetexturemid)
 {
     int64_t	topscreen; // [crispy] WiggleFix
     int64_t 	bottomscreen; // [crispy] WiggleFix
+
+    // calculate unclipped screen coordinates
+    //  for post
+    topscreen = sprtopscreen + spryscale*top;
+    bottomscreen = topscreen + spryscale*length;
+
+    dc_yl = (int)((topscreen+FRACUNIT-1)>>FRACBITS); // [crispy] WiggleFix
+    dc_yh = (int)((bottomscreen-1)>>FRACBITS); // [crispy] WiggleFix
+		
+    if (dc_yh >= mfloorclip[dc_x])
+	dc_yh = mfloorclip[dc_x]-1;
+    if (dc_yl <= mceilingclip[dc_x])
+	dc_yl = mceilingclip[dc_x]+1;
+
+    if (dc_yl <= dc_yh)
+    {
+	dc_source = source;
+	dc_texturemid = basetexturemid - (top<<FRACBITS);
+
+	if (dc_x >= stripx1 && dc_x <= stripx2)
+	{
+	    rstats.columns++;
+	    rstats.pixels += (dc_yh - dc_yl + 1) << detailshift;
+	}
+
+	// Drawn by either R_DrawColumn
+	//  or (SHADOW) R_DrawFuzzColumn.
+	colfunc ();	
+    }
+}
+
+void R_DrawMaskedColumn (column_t* column)
+{
     fixed_t	basetexturemid;
     int		top = -1;
 	
@@ -420,34 +500,35 @@ void R_DrawMaskedColumn (column_t* column)
 	{
 		top = column->topdelta;
 	}
-	// calculate unclipped screen coordinates
-	//  for post
-	topscreen = sprtopscreen + spryscale*top;
-	bottomscreen = topscreen + spryscale*column->length;
-
-	dc_yl = (int)((topscreen+FRACUNIT-1)>>FRACBITS); // [crispy] WiggleFix
-	dc_yh = (int)((bottomscreen-1)>>FRACBITS); // [crispy] WiggleFix
-		
-	if (dc_yh >= mfloorclip[dc_x])
-	    dc_yh = mfloorclip[dc_x]-1;
-	if (dc_yl <= mceilingclip[dc_x])
-	    dc_yl = mceilingclip[dc_x]+1;
 
-	if (dc_yl <= dc_yh)
-	{
-	    dc_source = (byte *)column + 3;
-	    dc_texturemid = basetexturemid - (top<<FRACBITS);
+	R_DrawMaskedPost(top, column->length, (byte *)column + 3, basetexturemid);
 
-	    // Drawn by either R_DrawColumn
-	    //  or (SHADOW) R_DrawFuzzColumn.
-	    colfunc ();	
-	}
 	column = (column_t *)(  (byte *)column + column->length + 4);
     }
 	
     dc_texturemid = basetexturemid;
 }
 
+//
+// R_DrawVPatchColumn
+// [crispy] Same as R_DrawMaskedColumn() for a column of a decoded
+//  patch, which has the posts ready to draw.
+//
+static void R_DrawVPatchColumn (const vpatch_t* vpatch, int col)
+{
+    const vpost_t*	post = &vpatch->posts[vpatch->columns[col]];
+    const vpost_t*	lastpost = &vpatch->posts[vpatch->columns[col+1]];
+    fixed_t		basetexturemid;
+
+    basetexturemid = dc_texturemid;
+    dc_texheight = 0; // [crispy] Tutti-Frutti fix
+
+    for ( ; post < lastpost ; post++)
+	R_DrawMaskedPost(post->topdelta, post->length, post->pixels, basetexturemid);
+
+    dc_texturemid = basetexturemid;
+}
+
 
 
 //
@@ -460,13 +541,23 @@ R_DrawVisSprite
   int			x1,
   int			x2 )
 {
-    column_t*		column;
     int			texturecolumn;
     fixed_t		frac;
     patch_t*		patch;
+    const vpatch_t*	vpatch;
 	
-	
-    patch = W_CacheLumpNum (vis->patch+firstspritelump, PU_CACHE);
+    I_LockCache();
+
+    // [crispy] sprite lumps of the level come from the texture arena
+    patch = arenasprites ? arenasprites[vis->patch] : NULL;
+
+    if (!patch)
+	patch = R_CacheLumpForFrame (vis->patch+firstspritelump);
+
+    // [crispy] drawn from the decoded posts
+    vpatch = V_DecodePatchNum (vis->patch+firstspritelump, patch);
+
+    I_UnlockCache();
 
     // [crispy] brightmaps for select sprites
     dc_colormap[0] = vis->colormap[0];
@@ -500,9 +591,15 @@ R_DrawVisSprite
     for (dc_x=vis->x1 ; dc_x<=vis->x2 ; dc_x++, frac += vis->xiscale)
     {
 	static boolean error = false;
+
+	// columns of other strips are left to their threads, but
+	// shadows still pass them on to keep the fuzz pattern in step
+	if ((dc_x < stripx1 || dc_x > stripx2) && colfunc != fuzzcolfunc)
+	    continue;
+
 	texturecolumn = frac>>FRACBITS;
 #ifdef RANGECHECK
-	if (texturecolumn < 0 || texturecolumn >= SHORT(patch->width))
+	if (texturecolumn < 0 || texturecolumn >= vpatch->width)
 	{
 	    // [crispy] make non-fatal
 	    if (!error)
@@ -513,9 +610,7 @@ R_DrawVisSprite
 	    continue;
 	}
 #endif
-	column = (column_t *) ((byte *)patch +
-			       LONG(patch->columnofs[texturecolumn]));
-	R_DrawMaskedColumn (column);
+	R_DrawVPatchColumn (vpatch, texturecolumn);
     }
 
     colfunc = basecolfunc;
@@ -565,10 +660,25 @@ void R_ProjectSprite (mobj_t* thing)
 
     // [AM] Interpolate between current and last position,
     //      if prudent.
-    interpx = thing->x;
-    interpy = thing->y;
-    interpz = thing->z;
-    interpangle = thing->angle;
+    if (uncapped &&
+        // Don't interpolate if the mobj did something
+        // that would necessitate turning it off for a tic.
+        thing->interp &&
+        // Don't interpolate during a paused state.
+        leveltime > oldleveltime)
+    {
+        interpx = thing->oldx + FixedMul(thing->x - thing->oldx, fractionaltic);
+        interpy = thing->oldy + FixedMul(thing->y - thing->oldy, fractionaltic);
+        interpz = thing->oldz + FixedMul(thing->z - thing->oldz, fractionaltic);
+        interpangle = R_InterpolateAngle(thing->oldangle, thing->angle, fractionaltic);
+    }
+    else
+    {
+        interpx = thing->x;
+        interpy = thing->y;
+        interpz = thing->z;
+        interpangle = thing->angle;
+    }
 
     // transform the origin point
     tr_x = interpx - viewx;
@@ -745,6 +855,10 @@ byte *R_LaserspotColor (void)
 	return NULL;
 }
 
+// per-thread copy of sector_t.validcount, see R_AddSprites()
+static THREADLOCAL int *sectorvalid;
+static THREADLOCAL int numsectorvalid;
+
 //
 // R_AddSprites
 // During BSP traversal, this adds sprites by sector.
@@ -758,11 +872,31 @@ void R_AddSprites (sector_t* sec)
     // A sector might have been split into several
     //  subsectors during BSP building.
     // Thus we check whether its already added.
-    if (sec->validcount == validcount)
-	return;		
+    // With several render threads every thread walks the whole
+    // BSP, so each one keeps its own marks for the level sectors.
+    if (numrenderstrips > 1 && sec >= sectors && sec < sectors + numsectors)
+    {
+	if (numsectorvalid < numsectors)
+	{
+	    sectorvalid = I_Realloc(sectorvalid, numsectors * sizeof(*sectorvalid));
+	    memset(sectorvalid + numsectorvalid, 0,
+	           (numsectors - numsectorvalid) * sizeof(*sectorvalid));
+	    numsectorvalid = numsectors;
+	}
+
+	if (sectorvalid[sec - sectors] == validcount)
+	    return;
 
-    // Well, now it will be done.
-    sec->validcount = validcount;
+	sectorvalid[sec - sectors] = validcount;
+    }
+    else
+    {
+	if (sec->validcount == validcount)
+	    return;
+
+	// Well, now it will be done.
+	sec->validcount = validcount;
+    }
 	
     lightnum = (sec->lightlevel >> LIGHTSEGSHIFT)+(extralight * LIGHTBRIGHT);
 
@@ -936,94 +1070,174 @@ void R_DrawPlayerSprites (void)
 
 //
 // R_SortVisSprites
+// [crispy] Radix sort of the vissprites by scale into vsprsorted[].
+//  Every pass is stable, so deliberately overlaid sprites of the same
+//  scale keep the order they were projected in.
 //
-#ifdef HAVE_QSORT
-// [crispy] use stdlib's qsort() function for sorting the vissprites[] array
-static inline int cmp_vissprites (const void *a, const void *b)
-{
-    const vissprite_t *vsa = (const vissprite_t *) a;
-    const vissprite_t *vsb = (const vissprite_t *) b;
-
-    const int ret = vsa->scale - vsb->scale;
-
-    return ret ? ret : vsa->next - vsb->next;
-}
-
 void R_SortVisSprites (void)
 {
-    int count;
-    vissprite_t *ds;
+    vissprite_t**	src = vsprsorted;
+    vissprite_t**	dest = vsprscratch;
+    vissprite_t**	swap;
+    int			count[256];
+    int			i, n, sum, shift;
 
-    count = vissprite_p - vissprites;
+    n = vissprite_p - vissprites;
+
+    for (i = 0 ; i < n ; i++)
+	src[i] = &vissprites[i];
 
-    if (!count)
+    if (n < 2)
 	return;
 
-    // [crispy] maintain a stable sort for deliberately overlaid sprites
-    for (ds = vissprites; ds < vissprite_p; ds++)
+    for (shift = 0 ; shift < 32 ; shift += 8)
     {
-	ds->next = ds + 1;
+	memset(count, 0, sizeof(count));
+
+	for (i = 0 ; i < n ; i++)
+	    count[VISSPRITEKEY(src[i], shift)]++;
+
+	// all of them share this digit, nothing to reorder
+	if (count[VISSPRITEKEY(src[0], shift)] == n)
+	    continue;
+
+	for (i = 0, sum = 0 ; i < 256 ; i++)
+	{
+	    const int c = count[i];
+	    count[i] = sum;
+	    sum += c;
+	}
+
+	for (i = 0 ; i < n ; i++)
+	    dest[count[VISSPRITEKEY(src[i], shift)]++] = src[i];
+
+	swap = src;
+	src = dest;
+	dest = swap;
     }
 
-    qsort(vissprites, count, sizeof(*vissprites), cmp_vissprites);
+    vsprsorted = src;
+    vsprscratch = dest;
 }
-#else
-vissprite_t	vsprsortedhead;
 
 
-void R_SortVisSprites (void)
+
+//
+// [crispy] Screen-column index of the drawsegs that clip sprites or have
+// masked mid textures, so R_DrawSprite() only visits the ones overlapping
+// the sprite.  Every band of DSBANDWIDTH columns lists its drawsegs from
+// the last one stored to the first, the order they are scanned in.
+//
+#define DSBANDSHIFT	5
+#define DSBANDWIDTH	(1 << DSBANDSHIFT)
+#define MAXDSBANDS	((MAXWIDTH + DSBANDWIDTH - 1) >> DSBANDSHIFT)
+
+static THREADLOCAL drawseg_t**	dsbands; // band lists, one after the other
+static THREADLOCAL int		numdsbands;
+static THREADLOCAL int		dsbandstart[MAXDSBANDS + 1];
+static THREADLOCAL drawseg_t**	dsmerged; // merged lists of several bands
+static THREADLOCAL int		numdsmerged;
+
+//
+// R_IndexDrawSegs
+// Called before the masked pass, once all drawsegs are stored.
+//
+static void R_IndexDrawSegs (void)
 {
-    int			i;
-    int			count;
-    vissprite_t*	ds;
-    vissprite_t*	best;
-    vissprite_t		unsorted;
-    fixed_t		bestscale;
+    drawseg_t*		ds;
+    int			next[MAXDSBANDS];
+    int			b, total;
 
-    count = vissprite_p - vissprites;
-	
-    unsorted.next = unsorted.prev = &unsorted;
+    memset(next, 0, sizeof(next));
 
-    if (!count)
-	return;
-		
-    for (ds=vissprites ; ds<vissprite_p ; ds++)
+    for (ds = ds_p-1 ; ds >= drawsegs ; ds--)
     {
-	ds->next = ds+1;
-	ds->prev = ds-1;
+	if (!ds->silhouette && !ds->maskedtexturecol)
+	    continue;
+
+	for (b = ds->x1 >> DSBANDSHIFT ; b <= ds->x2 >> DSBANDSHIFT ; b++)
+	    next[b]++;
     }
-    
-    vissprites[0].prev = &unsorted;
-    unsorted.next = &vissprites[0];
-    (vissprite_p-1)->next = &unsorted;
-    unsorted.prev = vissprite_p-1;
-    
-    // pull the vissprites out by scale
 
-    vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
-    for (i=0 ; i<count ; i++)
+    for (b = 0, total = 0 ; b < MAXDSBANDS ; b++)
     {
-	bestscale = INT_MAX;
-        best = unsorted.next;
-	for (ds=unsorted.next ; ds!= &unsorted ; ds=ds->next)
-	{
-	    if (ds->scale < bestscale)
-	    {
-		bestscale = ds->scale;
-		best = ds;
-	    }
-	}
-	best->next->prev = best->prev;
-	best->prev->next = best->next;
-	best->next = &vsprsortedhead;
-	best->prev = vsprsortedhead.prev;
-	vsprsortedhead.prev->next = best;
-	vsprsortedhead.prev = best;
+	dsbandstart[b] = total;
+	total += next[b];
+	next[b] = dsbandstart[b];
+    }
+    dsbandstart[MAXDSBANDS] = total;
+
+    if (total > numdsbands)
+    {
+	numdsbands = 2 * total;
+	dsbands = I_Realloc(dsbands, numdsbands * sizeof(*dsbands));
+    }
+
+    if (numdrawsegs > numdsmerged)
+    {
+	numdsmerged = numdrawsegs;
+	dsmerged = I_Realloc(dsmerged, numdsmerged * sizeof(*dsmerged));
+    }
+
+    for (ds = ds_p-1 ; ds >= drawsegs ; ds--)
+    {
+	if (!ds->silhouette && !ds->maskedtexturecol)
+	    continue;
+
+	for (b = ds->x1 >> DSBANDSHIFT ; b <= ds->x2 >> DSBANDSHIFT ; b++)
+	    dsbands[next[b]++] = ds;
     }
 }
-#endif
 
+//
+// R_BandSegs
+// Returns the indexed drawsegs in the bands of columns x1 to x2,
+//  in scan order and each one once.
+//
+static drawseg_t** R_BandSegs (int x1, int x2, int *count)
+{
+    drawseg_t**		pos[MAXDSBANDS];
+    drawseg_t**		end[MAXDSBANDS];
+    drawseg_t*		ds;
+    const int		b1 = x1 >> DSBANDSHIFT;
+    const int		b2 = x2 >> DSBANDSHIFT;
+    int			b, n;
+
+    if (b1 == b2)
+    {
+	*count = dsbandstart[b1+1] - dsbandstart[b1];
+	return dsbands + dsbandstart[b1];
+    }
+
+    for (b = b1 ; b <= b2 ; b++)
+    {
+	pos[b] = dsbands + dsbandstart[b];
+	end[b] = dsbands + dsbandstart[b+1];
+    }
+
+    // merge the band lists, a drawseg spanning several
+    // bands is at the head of all of them at once
+    for (n = 0 ; ; n++)
+    {
+	ds = NULL;
+
+	for (b = b1 ; b <= b2 ; b++)
+	    if (pos[b] < end[b] && (ds == NULL || *pos[b] > ds))
+		ds = *pos[b];
+
+	if (ds == NULL)
+	    break;
+
+	for (b = b1 ; b <= b2 ; b++)
+	    if (pos[b] < end[b] && *pos[b] == ds)
+		pos[b]++;
 
+	dsmerged[n] = ds;
+    }
+
+    *count = n;
+    return dsmerged;
+}
 
 //
 // R_DrawSprite
@@ -1031,8 +1245,10 @@ void R_SortVisSprites (void)
 void R_DrawSprite (vissprite_t* spr)
 {
     drawseg_t*		ds;
-    int		clipbot[SCREENWIDTH]; // [crispy] 32-bit integer math
-    int		cliptop[SCREENWIDTH]; // [crispy] 32-bit integer math
+    drawseg_t**		segs;
+    int			i, count;
+    int		clipbot[MAXWIDTH]; // [crispy] 32-bit integer math
+    int		cliptop[MAXWIDTH]; // [crispy] 32-bit integer math
     int			x;
     int			r1;
     int			r2;
@@ -1046,8 +1262,12 @@ void R_DrawSprite (vissprite_t* spr)
     // Scan drawsegs from end to start for obscuring segs.
     // The first drawseg that has a greater scale
     //  is the clip seg.
-    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+    segs = R_BandSegs(spr->x1, spr->x2, &count);
+
+    for (i = 0 ; i < count ; i++)
     {
+	ds = segs[i];
+
 	// determine if the drawseg obscures the sprite
 	if (ds->x1 > spr->x2
 	    || ds->x2 < spr->x1
@@ -1189,33 +1409,24 @@ void R_DrawSprite (vissprite_t* spr)
 //
 void R_DrawMasked (void)
 {
-    vissprite_t*	spr;
-    drawseg_t*		ds;
+    drawseg_t**		segs;
+    int			i, count;
 	
     R_SortVisSprites ();
+    R_IndexDrawSegs ();
 
-    if (vissprite_p > vissprites)
-    {
-	// draw all vissprites back to front
-#ifdef HAVE_QSORT
-	for (spr = vissprites;
-	     spr < vissprite_p;
-	     spr++)
-#else
-	for (spr = vsprsortedhead.next ;
-	     spr != &vsprsortedhead ;
-	     spr=spr->next)
-#endif
-	{
-	    
-	    R_DrawSprite (spr);
-	}
-    }
+    // draw all vissprites back to front
+    count = vissprite_p - vissprites;
+
+    for (i = 0 ; i < count ; i++)
+	R_DrawSprite (vsprsorted[i]);
     
     // render any remaining masked mid textures
-    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
-	if (ds->maskedtexturecol)
-	    R_RenderMaskedSegRange (ds, ds->x1, ds->x2);
+    segs = R_BandSegs(stripx1, stripx2, &count);
+
+    for (i = 0 ; i < count ; i++)
+	if (segs[i]->maskedtexturecol)
+	    R_RenderMaskedSegRange (segs[i], segs[i]->x1, segs[i]->x2);
     
     // if (crispy->cleanscreenshot == 2)
     //     return;
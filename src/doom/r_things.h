@@ -24,20 +24,19 @@
 
 #define MAXVISSPRITES  	128
 
-extern vissprite_t*	vissprites;
-extern vissprite_t*	vissprite_p;
-extern vissprite_t	vsprsortedhead;
+extern THREADLOCAL vissprite_t*	vissprites;
+extern THREADLOCAL vissprite_t*	vissprite_p;
 
 // Constant arrays used for psprite clipping
 //  and initializing clipping.
-extern int		negonearray[SCREENWIDTH];
-extern int		screenheightarray[SCREENWIDTH];
+extern int		negonearray[MAXWIDTH];
+extern int		screenheightarray[MAXWIDTH];
 
 // vars for R_DrawMaskedColumn
-extern int*		mfloorclip; // [crispy] 32-bit integer math
-extern int*		mceilingclip; // [crispy] 32-bit integer math
-extern fixed_t		spryscale;
-extern int64_t		sprtopscreen; // [crispy] WiggleFix
+extern THREADLOCAL int*		mfloorclip; // [crispy] 32-bit integer math
+extern THREADLOCAL int*		mceilingclip; // [crispy] 32-bit integer math
+extern THREADLOCAL fixed_t		spryscale;
+extern THREADLOCAL int64_t		sprtopscreen; // [crispy] WiggleFix
 
 extern fixed_t		pspritescale;
 extern fixed_t		pspriteiscale;
@@ -56,6 +56,31 @@ void STlib_init(void)
 }
 
 
+//
+// [crispy] The widgets draw into st_composed_screen, which keeps the
+//  whole status bar as last drawn.  Only the rectangles that changed
+//  are copied to the screen, see ST_doRefresh() for the rest.
+//
+static void STlib_drawPatch (int x, int y, patch_t *patch)
+{
+    V_UseBuffer(st_composed_screen);
+    V_DrawPatch(x, y - ST_Y, patch);
+    V_RestoreBuffer();
+}
+
+static void STlib_eraseRect (int x, int y, int w, int h)
+{
+    V_UseBuffer(st_composed_screen);
+    V_CopyRect(x, y - ST_Y, st_backing_screen, w, h, x, y - ST_Y);
+    V_RestoreBuffer();
+}
+
+static void STlib_showRect (int x, int y, int w, int h)
+{
+    V_CopyRect(x, y - ST_Y, st_composed_screen, w, h, x, y);
+}
+
+
 // ?
 void
 STlib_initNum
@@ -67,6 +92,8 @@ STlib_initNum
   boolean*		on,
   int			width )
 {
+    int i;
+
     n->x	= x;
     n->y	= y;
     n->oldnum	= 0;
@@ -74,13 +101,17 @@ STlib_initNum
     n->num	= num;
     n->on	= on;
     n->p	= pl;
+
+    for (i = 0; i < ST_MAXNUMWIDTH; i++)
+	n->olddigits[i] = -1;
+    n->oldneg	= false;
 }
 
 
 // 
 // A fairly efficient way to draw a number
 //  based on differences from the old number.
-// Note: worth the trouble?
+// [crispy] Only the digits that changed are redrawn.
 //
 void
 STlib_drawNum
@@ -93,9 +124,18 @@ STlib_drawNum
     
     int		w = SHORT(n->p[0]->width);
     int		h = SHORT(n->p[0]->height);
-    int		x = n->x;
+    int		x;
     
     int		neg;
+    int		digits[ST_MAXNUMWIDTH];
+    int		count = 0;
+    int		i;
+
+    if (n->y - ST_Y < 0)
+	I_Error("drawNum: n->y - ST_Y < 0");
+
+    if (!refresh && num == n->oldnum)
+	return;
 
     n->oldnum = *n->num;
 
@@ -111,35 +151,52 @@ STlib_drawNum
 	num = -num;
     }
 
-    // clear the area
-    x = n->x - numdigits*w;
-
-    if (n->y - ST_Y < 0)
-	I_Error("drawNum: n->y - ST_Y < 0");
-
-    V_CopyRect(x, n->y - ST_Y, st_backing_screen, w*numdigits, h, x, n->y);
+    for (i = 0; i < numdigits; i++)
+	digits[i] = -1;
 
     // if non-number, do not draw it
     if (num == 1994)
-	return;
-
-    x = n->x;
-
+	neg = false;
     // in the special case of 0, you draw 0
-    if (!num)
-	V_DrawPatch(x - w, n->y, n->p[ 0 ]);
+    else if (!num)
+	digits[0] = 0;
+    else
+	while (num && count < numdigits)
+	{
+	    digits[count++] = num % 10;
+	    num /= 10;
+	}
+
+    // the minus sign moves with the number
+    if (neg || n->oldneg)
+	refresh = true;
 
-    // draw the new number
-    while (num && numdigits--)
+    for (i = 0; i < numdigits; i++)
     {
-	x -= w;
-	V_DrawPatch(x, n->y, n->p[ num % 10 ]);
-	num /= 10;
+	if (!refresh && digits[i] == n->olddigits[i])
+	    continue;
+
+	x = n->x - (i + 1) * w;
+
+	STlib_eraseRect(x, n->y, w, h);
+
+	if (digits[i] != -1)
+	    STlib_drawPatch(x, n->y, n->p[digits[i]]);
+
+	STlib_showRect(x, n->y, w, h);
+	n->olddigits[i] = digits[i];
     }
 
     // draw a minus sign if necessary
     if (neg)
-	V_DrawPatch(x - 8, n->y, sttminus);
+    {
+	x = n->x - count * w - 8;
+
+	STlib_drawPatch(x, n->y, sttminus);
+	STlib_showRect(x, n->y, SHORT(sttminus->width), SHORT(sttminus->height));
+    }
+
+    n->oldneg = neg;
 }
 
 
@@ -177,7 +234,12 @@ STlib_updatePercent
   int			refresh )
 {
     if (refresh && *per->n.on)
-	V_DrawPatch(per->n.x, per->n.y, per->p);
+    {
+	STlib_drawPatch(per->n.x, per->n.y, per->p);
+	STlib_showRect(per->n.x - SHORT(per->p->leftoffset),
+	               per->n.y - SHORT(per->p->topoffset),
+	               SHORT(per->p->width), SHORT(per->p->height));
+    }
     
     STlib_updateNum(&per->n, refresh);
 }
@@ -208,10 +270,11 @@ STlib_updateMultIcon
 ( st_multicon_t*	mi,
   boolean		refresh )
 {
-    int			w;
-    int			h;
-    int			x;
-    int			y;
+    int			w = 0;
+    int			h = 0;
+    int			x = 0;
+    int			y = 0;
+    patch_t*		p;
 
     if (*mi->on
 	&& (mi->oldinum != *mi->inum || refresh)
@@ -227,9 +290,18 @@ STlib_updateMultIcon
 	    if (y - ST_Y < 0)
 		I_Error("updateMultIcon: y - ST_Y < 0");
 
-	    V_CopyRect(x, y-ST_Y, st_backing_screen, w, h, x, y);
+	    STlib_eraseRect(x, y, w, h);
 	}
-	V_DrawPatch(mi->x, mi->y, mi->p[*mi->inum]);
+
+	p = mi->p[*mi->inum];
+	STlib_drawPatch(mi->x, mi->y, p);
+
+	// [crispy] show where the old icon was and where the new one is
+	if (mi->oldinum != -1)
+	    STlib_showRect(x, y, w, h);
+	STlib_showRect(mi->x - SHORT(p->leftoffset), mi->y - SHORT(p->topoffset),
+	               SHORT(p->width), SHORT(p->height));
+
 	mi->oldinum = *mi->inum;
     }
 }
@@ -277,9 +349,11 @@ STlib_updateBinIcon
 	    I_Error("updateBinIcon: y - ST_Y < 0");
 
 	if (*bi->val)
-	    V_DrawPatch(bi->x, bi->y, bi->p);
+	    STlib_drawPatch(bi->x, bi->y, bi->p);
 	else
-	    V_CopyRect(x, y-ST_Y, st_backing_screen, w, h, x, y);
+	    STlib_eraseRect(x, y, w, h);
+
+	STlib_showRect(x, y, w, h);
 
 	bi->oldval = *bi->val;
     }
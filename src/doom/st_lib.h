@@ -28,6 +28,9 @@
 // Typedefs of widgets
 //
 
+// [crispy] widest number widget, in digits
+#define ST_MAXNUMWIDTH	3
+
 // Number widget
 
 typedef struct
@@ -42,6 +45,10 @@ typedef struct
 
     // last number value
     int		oldnum;
+
+    // [crispy] last digits drawn, right to left, -1 for blank
+    int		olddigits[ST_MAXNUMWIDTH];
+    boolean	oldneg;
     
     // pointer to current value
     int*	num;
@@ -264,6 +264,12 @@ extern boolean havee1m10;
 
 // graphics are drawn to a backing screen and blitted to the real screen
 pixel_t			*st_backing_screen;
+
+// [crispy] the status bar as last drawn, background and widgets
+pixel_t			*st_composed_screen;
+
+// [crispy] st_composed_screen is up to date since ST_Start()
+static boolean		st_composed;
 	    
 // main player in game
 static player_t*	plyr; 
@@ -428,9 +434,10 @@ void ST_refreshBackground(void)
 	if (netgame)
 	    V_DrawPatch(ST_FX, 0, faceback);
 
+        // [crispy] the widgets are drawn on top in st_composed_screen
+        V_UseBuffer(st_composed_screen);
+	V_CopyRect(ST_X, 0, st_backing_screen, ST_WIDTH, ST_HEIGHT, ST_X, 0);
         V_RestoreBuffer();
-
-	V_CopyRect(ST_X, 0, st_backing_screen, ST_WIDTH, ST_HEIGHT, ST_X, ST_Y);
     }
 
 }
@@ -1073,11 +1080,27 @@ void ST_doRefresh(void)
 
     st_firsttime = false;
 
-    // draw status bar background to off-screen buff
-    ST_refreshBackground();
+    if (!st_statusbaron)
+	return;
+
+    // [crispy] only compose the status bar again after ST_Start(),
+    // otherwise bring the composed one up to date
+    if (!st_composed)
+    {
+	// draw status bar background to off-screen buff
+	ST_refreshBackground();
+
+	// and refresh all widgets
+	ST_drawWidgets(true);
+
+	st_composed = true;
+    }
+    else
+    {
+	ST_drawWidgets(false);
+    }
 
-    // and refresh all widgets
-    ST_drawWidgets(true);
+    V_CopyRect(ST_X, 0, st_composed_screen, ST_WIDTH, ST_HEIGHT, ST_X, ST_Y);
 
 }
 
@@ -1097,7 +1120,7 @@ void ST_Drawer (boolean fullscreen, boolean refresh)
     ST_doPaletteStuff();
 
     // If just after ST_Start(), refresh all
-    if (st_firsttime) ST_doRefresh();
+    if (st_firsttime || !st_composed) ST_doRefresh();
     // Otherwise, update as little as possible
     else ST_diffDraw();
 
@@ -1232,6 +1255,7 @@ void ST_initData(void)
     int		i;
 
     st_firsttime = true;
+    st_composed = false;
     plyr = &players[consoleplayer];
 
     st_clock = 0;
@@ -1448,5 +1472,6 @@ void ST_Init (void)
 {
     ST_loadData();
     st_backing_screen = (pixel_t *) Z_Malloc(ST_WIDTH * ST_HEIGHT * sizeof(*st_backing_screen), PU_STATIC, 0);
+    st_composed_screen = (pixel_t *) Z_Malloc(ST_WIDTH * ST_HEIGHT * sizeof(*st_composed_screen), PU_STATIC, 0);
 }
 
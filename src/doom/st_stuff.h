@@ -78,6 +78,7 @@ typedef enum
 
 
 extern pixel_t *st_backing_screen;
+extern pixel_t *st_composed_screen;
 extern cheatseq_t cheat_mus;
 extern cheatseq_t cheat_god;
 extern cheatseq_t cheat_ammo;
@@ -0,0 +1,193 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Worker threads, built on SDL threads so that the same code
+//      runs on native threads and on Emscripten pthreads.
+//
+
+#include <stdio.h>
+
+#include "SDL.h"
+
+#include "i_system.h"
+#include "i_thread.h"
+#include "doomtype.h"
+
+typedef struct
+{
+    SDL_Thread *thread;
+    SDL_sem *start;
+    SDL_sem *done;
+    int job;
+} worker_t;
+
+static worker_t workers[MAXTHREADS];
+static int numworkers = 0;
+
+static threadfunc_t jobfunc;
+
+static SDL_mutex *cachelock = NULL;
+
+static int WorkerThread(void *data)
+{
+    worker_t *worker = data;
+
+    for (;;)
+    {
+        SDL_SemWait(worker->start);
+
+        // A NULL job function is the signal to quit.
+
+        if (jobfunc == NULL)
+        {
+            break;
+        }
+
+        jobfunc(worker->job);
+
+        SDL_SemPost(worker->done);
+    }
+
+    return 0;
+}
+
+static void I_ShutdownThreads(void)
+{
+    int i;
+
+    jobfunc = NULL;
+
+    for (i = 0; i < numworkers; ++i)
+    {
+        SDL_SemPost(workers[i].start);
+        SDL_WaitThread(workers[i].thread, NULL);
+        SDL_DestroySemaphore(workers[i].start);
+        SDL_DestroySemaphore(workers[i].done);
+    }
+
+    numworkers = 0;
+
+    if (cachelock != NULL)
+    {
+        SDL_DestroyMutex(cachelock);
+        cachelock = NULL;
+    }
+}
+
+int I_InitThreads(int numthreads)
+{
+    worker_t *worker;
+
+    if (numworkers > 0)
+    {
+        return numworkers + 1;
+    }
+
+    if (numthreads > MAXTHREADS)
+    {
+        numthreads = MAXTHREADS;
+    }
+
+    if (numthreads < 2)
+    {
+        return 1;
+    }
+
+    cachelock = SDL_CreateMutex();
+
+    if (cachelock == NULL)
+    {
+        fprintf(stderr, "I_InitThreads: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    while (numworkers < numthreads - 1)
+    {
+        worker = &workers[numworkers];
+
+        worker->start = SDL_CreateSemaphore(0);
+        worker->done = SDL_CreateSemaphore(0);
+        worker->thread = SDL_CreateThread(WorkerThread, "worker", worker);
+
+        if (worker->thread == NULL)
+        {
+            // Without thread support (eg. an Emscripten build without
+            // pthreads) this fails straight away, so carry on with
+            // however many workers we did get.
+
+            fprintf(stderr, "I_InitThreads: %s\n", SDL_GetError());
+            SDL_DestroySemaphore(worker->start);
+            SDL_DestroySemaphore(worker->done);
+            break;
+        }
+
+        ++numworkers;
+    }
+
+    if (numworkers == 0)
+    {
+        SDL_DestroyMutex(cachelock);
+        cachelock = NULL;
+        return 1;
+    }
+
+    I_AtExit(I_ShutdownThreads, true);
+
+    printf("I_InitThreads: Using %d threads.\n", numworkers + 1);
+
+    return numworkers + 1;
+}
+
+void I_RunJobs(threadfunc_t func, int numjobs)
+{
+    int i;
+
+    if (numjobs > numworkers + 1)
+    {
+        I_Error("I_RunJobs: %d jobs for %d threads", numjobs, numworkers + 1);
+    }
+
+    jobfunc = func;
+
+    for (i = 0; i < numjobs - 1; ++i)
+    {
+        workers[i].job = i + 1;
+        SDL_SemPost(workers[i].start);
+    }
+
+    func(0);
+
+    for (i = 0; i < numjobs - 1; ++i)
+    {
+        SDL_SemWait(workers[i].done);
+    }
+}
+
+void I_LockCache(void)
+{
+    if (cachelock != NULL)
+    {
+        SDL_LockMutex(cachelock);
+    }
+}
+
+void I_UnlockCache(void)
+{
+    if (cachelock != NULL)
+    {
+        SDL_UnlockMutex(cachelock);
+    }
+}
+
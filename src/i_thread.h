@@ -0,0 +1,41 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      System-specific worker thread interface
+//
+
+
+#ifndef __I_THREAD__
+#define __I_THREAD__
+
+#define MAXTHREADS 16
+
+typedef void (*threadfunc_t)(int job);
+
+// Start up to numthreads-1 worker threads.  Returns the number of
+// jobs that can run at once, including the calling thread.
+int I_InitThreads(int numthreads);
+
+// Run func(0) .. func(numjobs-1) in parallel, job 0 on the calling
+// thread, and return once all of them are done.
+void I_RunJobs(threadfunc_t func, int numjobs);
+
+// Serialize access to the zone and WAD caches while jobs are running.
+// Does nothing unless worker threads have been started.
+void I_LockCache(void);
+void I_UnlockCache(void);
+
+#endif
+
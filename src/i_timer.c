@@ -58,6 +58,22 @@ int I_GetTimeMS(void)
     return ticks - basetime;
 }
 
+//
+// Same as I_GetTimeMS, but returns time in microseconds, for profiling
+//
+
+static Uint64 basecount = 0;
+
+uint64_t I_GetTimeUS(void)
+{
+    Uint64 count, freq;
+
+    count = SDL_GetPerformanceCounter() - basecount;
+    freq = SDL_GetPerformanceFrequency();
+
+    return (count / freq) * 1000000 + (count % freq) * 1000000 / freq;
+}
+
 // Sleep for a specified number of ms
 
 void I_Sleep(int ms)
@@ -79,5 +95,7 @@ void I_InitTimer(void)
     SDL_SetHint(SDL_HINT_WINDOWS_DISABLE_THREAD_NAMING, "1");
 #endif
     SDL_Init(SDL_INIT_TIMER);
+
+    basecount = SDL_GetPerformanceCounter();
 }
 
@@ -50,29 +50,54 @@ static SDL_Renderer *renderer;
 static char *window_title = "";
 
 // These are (1) the 320x200x8 paletted buffer that we draw to (i.e. the one
-// that holds I_VideoBuffer), (2) the 320x200x32 RGBA intermediate buffer that
-// we blit the former buffer to, (3) the intermediate 320x200 texture that we
-// load the RGBA buffer to and that we render into another texture (4) which
-// is upscaled by an integer factor UPSCALE using "nearest" scaling and which
-// in turn is finally rendered to screen using "linear" scaling.
+// that holds I_VideoBuffer) and (2) the streaming texture that is upscaled
+// by the integer factors w_upscale and h_upscale.  Every frame the paletted
+// buffer is converted straight into the locked texture through the
+// rgbapalette[] lookup table, repeating the pixels and rows on the way, and
+// the texture is finally rendered to screen using "linear" scaling.  If the
+// CPU upscaled by less than the window needs, (3) the texture is first
+// rendered into a larger target texture using "nearest" integer scaling,
+// as it always was before the CPU took over part of the upscaling.
 
 static SDL_Surface *screenbuffer = NULL;
-static SDL_Surface *argbbuffer = NULL;
 static SDL_Texture *texture = NULL;
 static SDL_Texture *texture_upscaled = NULL;
 
-static SDL_Rect blit_rect = {
-    0,
-    0,
-    SCREENWIDTH,
-    SCREENHEIGHT
-};
+static int w_upscale, h_upscale;
+
+// The screen as last converted into the texture.  Rows that are the same
+// in the next frame, like those of an unchanged status bar, are neither
+// converted nor uploaded again.
+
+static pixel_t lastscreen[SCREENWIDTH * SCREENHEIGHT];
+static boolean texture_stale = true;
+
+// The view rendered at a higher resolution than the screen, set by
+// I_SetHiresView().  The texture takes the view from it instead of
+// repeating the pixels of the screen, except where something has been
+// drawn over the view since, which hiresshadow tells.
+
+typedef struct
+{
+    const pixel_t *buffer;
+    int pitch, width, height;
+    int x, y, w, h;
+} hiresview_t;
+
+static hiresview_t hiresview;
+static pixel_t hiresshadow[SCREENWIDTH * SCREENHEIGHT];
+
+// Rows of the texture last filled from the view, filled again from
+// the screen once there is no view.
+
+static int hiresrows1 = SCREENHEIGHT, hiresrows2 = -1;
 
 static uint32_t pixel_format;
 
 // palette
 
 static SDL_Color palette[256];
+static uint32_t rgbapalette[256];
 static boolean palette_to_set;
 
 // display has been set up?
@@ -113,6 +138,13 @@ int fullscreen_width = 0, fullscreen_height = 0;
 
 static int max_scaling_buffer_pixels = 16000000;
 
+// Integer factor to upscale the screen by before it is stretched to the
+// window, 0 to pick the smallest factor that covers the window.  Every
+// texture pixel is written by the CPU, so the default stays small and
+// leaves the rest of the integer upscaling to the GPU.
+
+static int video_upscale = 2;
+
 // Run in full screen mode?  (int type for config code)
 
 int fullscreen = false;
@@ -508,8 +540,9 @@ static void LimitTextureSize(int *w_upscale, int *h_upscale)
 static void CreateUpscaledTexture(boolean force)
 {
     int w, h;
-    int h_upscale, w_upscale;
+    int w_full, h_full;
     static int h_upscale_old, w_upscale_old;
+    static int h_full_old, w_full_old;
 
     // Get the size of the renderer output. The units this gives us will be
     // real world pixels, which are not necessarily equivalent to the screen's
@@ -540,48 +573,394 @@ static void CreateUpscaledTexture(boolean force)
     // If one screen dimension matches an integer multiple of the original
     // resolution, there is no need to overscale in this direction.
 
-    w_upscale = (w + SCREENWIDTH - 1) / SCREENWIDTH;
-    h_upscale = (h + SCREENHEIGHT - 1) / SCREENHEIGHT;
+    w_full = (w + SCREENWIDTH - 1) / SCREENWIDTH;
+    h_full = (h + SCREENHEIGHT - 1) / SCREENHEIGHT;
 
     // Minimum texture dimensions of 320x200.
 
-    if (w_upscale < 1)
+    if (w_full < 1)
     {
-        w_upscale = 1;
+        w_full = 1;
     }
-    if (h_upscale < 1)
+    if (h_full < 1)
     {
-        h_upscale = 1;
+        h_full = 1;
     }
 
-    LimitTextureSize(&w_upscale, &h_upscale);
+    LimitTextureSize(&w_full, &h_full);
+
+    // A fixed factor from the configuration file saves the CPU from
+    // filling a texture as large as the window, the GPU does the rest.
+
+    w_upscale = w_full;
+    h_upscale = h_full;
 
-    // Create a new texture only if the upscale factors have actually changed.
+    if (video_upscale > 0)
+    {
+        w_upscale = MIN(w_upscale, video_upscale);
+        h_upscale = MIN(h_upscale, video_upscale);
+    }
+
+    // Create new textures only if the upscale factors have actually changed.
 
-    if (h_upscale == h_upscale_old && w_upscale == w_upscale_old && !force)
+    if (h_upscale == h_upscale_old && w_upscale == w_upscale_old
+     && h_full == h_full_old && w_full == w_full_old && !force)
     {
         return;
     }
 
     h_upscale_old = h_upscale;
     w_upscale_old = w_upscale;
+    h_full_old = h_full;
+    w_full_old = w_full;
+
+    if (texture)
+    {
+        SDL_DestroyTexture(texture);
+    }
 
     if (texture_upscaled)
     {
         SDL_DestroyTexture(texture_upscaled);
+        texture_upscaled = NULL;
     }
 
     // Set the scaling quality for rendering the upscaled texture to "linear",
     // which looks much softer and smoother than "nearest" but does a better
-    // job at downscaling from the upscaled texture to screen.
+    // job at downscaling from the upscaled texture to screen.  A texture
+    // that does not cover the window yet is first rendered into a target
+    // texture that does, using "nearest" integer scaling.
+
+    if (w_upscale < w_full || h_upscale < h_full)
+    {
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+
+        texture_upscaled = SDL_CreateTexture(renderer,
+                                    pixel_format,
+                                    SDL_TEXTUREACCESS_TARGET,
+                                    w_full*SCREENWIDTH,
+                                    h_full*SCREENHEIGHT);
+
+        if (texture_upscaled == NULL)
+        {
+            I_Error("CreateUpscaledTexture: SDL_CreateTexture() failed: %s",
+                    SDL_GetError());
+        }
+
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    }
+    else
+    {
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    }
 
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    // The SDL_TEXTUREACCESS_STREAMING flag means that this texture's content
+    // is going to change frequently.
+
+    texture_stale = true;
 
-    texture_upscaled = SDL_CreateTexture(renderer,
+    texture = SDL_CreateTexture(renderer,
                                 pixel_format,
-                                SDL_TEXTUREACCESS_TARGET,
+                                SDL_TEXTUREACCESS_STREAMING,
                                 w_upscale*SCREENWIDTH,
                                 h_upscale*SCREENHEIGHT);
+
+    if (texture == NULL)
+    {
+        I_Error("CreateUpscaledTexture: SDL_CreateTexture() failed: %s",
+                SDL_GetError());
+    }
+}
+
+// Four texture pixels at a time for the row expansion below.
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+typedef v128_t pixvec_t;
+#define PIXVEC(a, b, c, d)	wasm_i32x4_make(a, b, c, d)
+#define PIXSPLAT(x)	wasm_i32x4_splat(x)
+#define PIXZIPLO(v)	wasm_i32x4_shuffle(v, v, 0, 0, 1, 1)
+#define PIXZIPHI(v)	wasm_i32x4_shuffle(v, v, 2, 2, 3, 3)
+#define PIXSTORE(p, v)	wasm_v128_store(p, v)
+#define HAVE_PIXVEC
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i pixvec_t;
+#define PIXVEC(a, b, c, d)	_mm_set_epi32(d, c, b, a)
+#define PIXSPLAT(x)	_mm_set1_epi32(x)
+#define PIXZIPLO(v)	_mm_unpacklo_epi32(v, v)
+#define PIXZIPHI(v)	_mm_unpackhi_epi32(v, v)
+#define PIXSTORE(p, v)	_mm_storeu_si128((__m128i *) (p), v)
+#define HAVE_PIXVEC
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+typedef uint32x4_t pixvec_t;
+#define PIXVEC(a, b, c, d)	((uint32x4_t) {a, b, c, d})
+#define PIXSPLAT(x)	vdupq_n_u32(x)
+#define PIXZIPLO(v)	vzipq_u32(v, v).val[0]
+#define PIXZIPHI(v)	vzipq_u32(v, v).val[1]
+#define PIXSTORE(p, v)	vst1q_u32(p, v)
+#define HAVE_PIXVEC
+#endif
+
+//
+// ExpandRow
+// Convert one row of the paletted screen buffer to texture pixels,
+// repeating every pixel xscale times.
+//
+static void ExpandRow(const byte *src, uint32_t *dest, int xscale)
+{
+    const uint32_t *const pal = rgbapalette;
+    int x, i;
+
+    if (xscale == 1)
+    {
+        for (x = 0; x < SCREENWIDTH; x += 4)
+        {
+            dest[0] = pal[src[0]];
+            dest[1] = pal[src[1]];
+            dest[2] = pal[src[2]];
+            dest[3] = pal[src[3]];
+            src += 4;
+            dest += 4;
+        }
+    }
+#ifdef HAVE_PIXVEC
+    else if (xscale == 2)
+    {
+        for (x = 0; x < SCREENWIDTH; x += 4)
+        {
+            const pixvec_t v = PIXVEC(pal[src[0]], pal[src[1]],
+                                      pal[src[2]], pal[src[3]]);
+
+            PIXSTORE(dest, PIXZIPLO(v));
+            PIXSTORE(dest + 4, PIXZIPHI(v));
+            src += 4;
+            dest += 8;
+        }
+    }
+    else if (xscale >= 4)
+    {
+        for (x = 0; x < SCREENWIDTH; x++)
+        {
+            const uint32_t c = pal[*src++];
+            const pixvec_t v = PIXSPLAT(c);
+
+            for (i = 0; i + 4 <= xscale; i += 4)
+            {
+                PIXSTORE(dest + i, v);
+            }
+            for ( ; i < xscale; i++)
+            {
+                dest[i] = c;
+            }
+            dest += xscale;
+        }
+    }
+#endif
+    else
+    {
+        for (x = 0; x < SCREENWIDTH; x++)
+        {
+            const uint32_t c = pal[*src++];
+
+            for (i = 0; i < xscale; i++)
+            {
+                *dest++ = c;
+            }
+        }
+    }
+}
+
+void I_SetHiresView(const pixel_t *buffer, int pitch, int width, int height,
+                    int x, int y, int w, int h)
+{
+    int i;
+
+    hiresview.buffer = buffer;
+    hiresview.pitch = pitch;
+    hiresview.width = width;
+    hiresview.height = height;
+    hiresview.x = x;
+    hiresview.y = y;
+    hiresview.w = w;
+    hiresview.h = h;
+
+    for (i = y; i < y + h; i++)
+    {
+        memcpy(hiresshadow + i * SCREENWIDTH + x,
+               I_VideoBuffer + i * SCREENWIDTH + x, w * sizeof(*hiresshadow));
+    }
+}
+
+//
+// ExpandHiresRow
+// Fill texture row sub of screen row y from the hires view, leaving
+// the pixels that were drawn over the view as ExpandRow() made them.
+//
+static void ExpandHiresRow(const hiresview_t *view, int y, int sub,
+                           uint32_t *dest)
+{
+    const uint32_t *const pal = rgbapalette;
+    const byte *screen = I_VideoBuffer + y * SCREENWIDTH + view->x;
+    const byte *shadow = hiresshadow + y * SCREENWIDTH + view->x;
+    const pixel_t *src;
+    const unsigned int step = (view->width << 16) / (view->w * w_upscale);
+    unsigned int frac = 0;
+    int x, i;
+
+    src = view->buffer + view->pitch * (((y - view->y) * h_upscale + sub)
+                                        * view->height / (view->h * h_upscale));
+    dest += view->x * w_upscale;
+
+    for (x = 0; x < view->w; x++)
+    {
+        if (screen[x] == shadow[x])
+        {
+            for (i = 0; i < w_upscale; i++)
+            {
+                dest[i] = pal[src[frac >> 16]];
+                frac += step;
+            }
+        }
+        else
+        {
+            frac += step * w_upscale;
+        }
+
+        dest += w_upscale;
+    }
+}
+
+//
+// UpdateTexture
+// Convert the rows of the paletted screen buffer that changed since the
+// last frame into the locked texture, upscaled by w_upscale and h_upscale.
+//
+static void UpdateTexture(void)
+{
+    const byte *src;
+    byte *dest;
+    SDL_Rect rect;
+    hiresview_t view;
+    int pitch;
+    int y, y1, y2, i;
+    int rows1, rows2;
+
+    // the view only counts for the frame it was rendered for
+
+    view = hiresview;
+    hiresview.buffer = NULL;
+
+    if (view.buffer != NULL && (w_upscale > 1 || h_upscale > 1))
+    {
+        rows1 = view.y;
+        rows2 = view.y + view.h - 1;
+    }
+    else
+    {
+        view.buffer = NULL;
+        rows1 = SCREENHEIGHT;
+        rows2 = -1;
+    }
+
+    y1 = 0;
+    y2 = SCREENHEIGHT - 1;
+
+    if (!texture_stale)
+    {
+        while (y1 < SCREENHEIGHT
+            && !memcmp(lastscreen + y1 * SCREENWIDTH,
+                       I_VideoBuffer + y1 * SCREENWIDTH,
+                       SCREENWIDTH * sizeof(*lastscreen)))
+        {
+            y1++;
+        }
+
+        while (y2 >= y1
+            && !memcmp(lastscreen + y2 * SCREENWIDTH,
+                       I_VideoBuffer + y2 * SCREENWIDTH,
+                       SCREENWIDTH * sizeof(*lastscreen)))
+        {
+            y2--;
+        }
+
+        // the rows of the view are filled again in any case
+
+        y1 = MIN(y1, MIN(rows1, hiresrows1));
+        y2 = MAX(y2, MAX(rows2, hiresrows2));
+
+        // nothing changed, the texture is still up to date
+
+        if (y1 > y2)
+        {
+            return;
+        }
+    }
+
+    rect.x = 0;
+    rect.y = y1 * h_upscale;
+    rect.w = w_upscale * SCREENWIDTH;
+    rect.h = (y2 - y1 + 1) * h_upscale;
+
+    if (SDL_LockTexture(texture, &rect, (void **) &dest, &pitch) != 0)
+    {
+        texture_stale = true;
+        return;
+    }
+
+    memcpy(lastscreen + y1 * SCREENWIDTH, I_VideoBuffer + y1 * SCREENWIDTH,
+           (y2 - y1 + 1) * SCREENWIDTH * sizeof(*lastscreen));
+    texture_stale = false;
+    hiresrows1 = rows1;
+    hiresrows2 = rows2;
+
+    src = I_VideoBuffer + y1 * SCREENWIDTH;
+
+    for (y = y1; y <= y2; y++)
+    {
+        ExpandRow(src, (uint32_t *) dest, w_upscale);
+
+        // repeat the converted row instead of converting it again
+
+        for (i = 1; i < h_upscale; i++)
+        {
+            memcpy(dest + i * pitch, dest, w_upscale * SCREENWIDTH * 4);
+        }
+
+        if (y >= rows1 && y <= rows2)
+        {
+            for (i = 0; i < h_upscale; i++)
+            {
+                ExpandHiresRow(&view, y, i, (uint32_t *) (dest + i * pitch));
+            }
+        }
+
+        src += SCREENWIDTH;
+        dest += h_upscale * pitch;
+    }
+
+    SDL_UnlockTexture(texture);
+}
+
+//
+// SetRGBAPalette
+// Pack the palette into the pixel format of the texture.
+//
+static void SetRGBAPalette(void)
+{
+    SDL_PixelFormat *format;
+    int i;
+
+    format = SDL_AllocFormat(pixel_format);
+
+    for (i = 0; i < 256; ++i)
+    {
+        rgbapalette[i] = SDL_MapRGBA(format, palette[i].r, palette[i].g,
+                                     palette[i].b, SDL_ALPHA_OPAQUE);
+    }
+
+    SDL_FreeFormat(format);
 }
 
 //
@@ -619,10 +998,18 @@ void I_FinishUpdate (void)
     // Draw disk icon before blit, if necessary.
     V_DrawDiskIcon();
 
+    if (need_resize && SDL_GetTicks() > last_resize_time + RESIZE_DELAY)
+    {
+        CreateUpscaledTexture(false);
+        need_resize = false;
+    }
+
     if (palette_to_set)
     {
         SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
+        SetRGBAPalette();
         palette_to_set = false;
+        texture_stale = true;
 
         if (vga_porch_flash)
         {
@@ -633,29 +1020,29 @@ void I_FinishUpdate (void)
         }
     }
 
-    // Blit from the paletted 8-bit screen buffer to the intermediate
-    // 32-bit RGBA buffer that we can load into the texture.
-
-    SDL_LowerBlit(screenbuffer, &blit_rect, argbbuffer, &blit_rect);
-
-    // Update the intermediate texture with the contents of the RGBA buffer.
+    // Convert the paletted 8-bit screen buffer straight into the
+    // upscaled texture.
 
-    SDL_UpdateTexture(texture, NULL, argbbuffer->pixels, argbbuffer->pitch);
+    UpdateTexture();
 
     // Make sure the pillarboxes are kept clear each frame.
 
     SDL_RenderClear(renderer);
 
-    // Render this intermediate texture into the upscaled texture
-    // using "nearest" integer scaling.
+    // Render the upscaled texture to screen using linear scaling, through
+    // the larger one using "nearest" integer scaling if there is one.
 
-    SDL_SetRenderTarget(renderer, texture_upscaled);
-    SDL_RenderCopy(renderer, texture, NULL, NULL);
-
-    // Finally, render this upscaled texture to screen using linear scaling.
-
-    SDL_SetRenderTarget(renderer, NULL);
-    SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
+    if (texture_upscaled)
+    {
+        SDL_SetRenderTarget(renderer, texture_upscaled);
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+        SDL_SetRenderTarget(renderer, NULL);
+        SDL_RenderCopy(renderer, texture_upscaled, NULL, NULL);
+    }
+    else
+    {
+        SDL_RenderCopy(renderer, texture, NULL, NULL);
+    }
 
     // Draw!
 
@@ -871,8 +1258,6 @@ static void SetVideoMode(void)
 {
     int w, h;
     int x = 0, y = 0;
-    unsigned int rmask, gmask, bmask, amask;
-    int unused_bpp;
     int window_flags = 0, renderer_flags = 0;
     SDL_DisplayMode mode;
 
@@ -923,11 +1308,18 @@ static void SetVideoMode(void)
 
         pixel_format = SDL_GetWindowPixelFormat(screen);
 
+        // The texture is filled with 32-bit pixels.
+
+        if (SDL_BYTESPERPIXEL(pixel_format) != 4)
+        {
+            pixel_format = SDL_PIXELFORMAT_ARGB8888;
+        }
+
         I_InitWindowTitle();
     }
 
     // The SDL_RENDERER_TARGETTEXTURE flag is required to render the
-    // intermediate texture into the upscaled texture.
+    // streaming texture into the upscaled texture.
     renderer_flags = SDL_RENDERER_TARGETTEXTURE;
 	
     if (SDL_GetCurrentDisplayMode(video_display, &mode) != 0)
@@ -985,7 +1377,7 @@ static void SetVideoMode(void)
     SDL_RenderClear(renderer);
     SDL_RenderPresent(renderer);
 
-    // Create the 8-bit paletted and the 32-bit RGBA screenbuffer surfaces.
+    // Create the 8-bit paletted screenbuffer surface.
 
     if (screenbuffer == NULL)
     {
@@ -995,37 +1387,10 @@ static void SetVideoMode(void)
         SDL_FillRect(screenbuffer, NULL, 0);
     }
 
-    // Format of argbbuffer must match the screen pixel format because we
-    // import the surface data into the texture.
-    if (argbbuffer == NULL)
-    {
-        SDL_PixelFormatEnumToMasks(pixel_format, &unused_bpp,
-                                   &rmask, &gmask, &bmask, &amask);
-        argbbuffer = SDL_CreateRGBSurface(0,
-                                          SCREENWIDTH, SCREENHEIGHT, 32,
-                                          rmask, gmask, bmask, amask);
-        SDL_FillRect(argbbuffer, NULL, 0);
-    }
+    // The textures belonged to the old renderer, if there was one.
 
-    if (texture != NULL)
-    {
-        SDL_DestroyTexture(texture);
-    }
-
-    // Set the scaling quality for rendering the intermediate texture into
-    // the upscaled texture to "nearest", which is gritty and pixelated and
-    // resembles software scaling pretty well.
-
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-
-    // Create the intermediate texture that the RGBA surface gets loaded into.
-    // The SDL_TEXTUREACCESS_STREAMING flag means that this texture's content
-    // is going to change frequently.
-
-    texture = SDL_CreateTexture(renderer,
-                                pixel_format,
-                                SDL_TEXTUREACCESS_STREAMING,
-                                SCREENWIDTH, SCREENHEIGHT);
+    texture = NULL;
+    texture_upscaled = NULL;
 
     // Initially create the upscaled texture for rendering to screen
 
@@ -1087,11 +1452,12 @@ void I_InitGraphics(void)
     doompal = W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE);
     I_SetPalette(doompal);
     SDL_SetPaletteColors(screenbuffer->format->palette, palette, 0, 256);
+    SetRGBAPalette();
 
     // The actual 320x200 canvas that we draw to. This is the pixel buffer of
-    // the 8-bit paletted screen buffer that gets blit on an intermediate
-    // 32-bit RGBA screen buffer that gets loaded into a texture that gets
-    // finally rendered into our window or full screen in I_FinishUpdate().
+    // the 8-bit paletted screen buffer that gets converted into a texture
+    // that gets finally rendered into our window or full screen in
+    // I_FinishUpdate().
 
     I_VideoBuffer = screenbuffer->pixels;
     V_RestoreBuffer();
@@ -1140,6 +1506,7 @@ void I_BindVideoVariables(void)
     M_BindIntVariable("fullscreen_height",         &fullscreen_height);
     M_BindIntVariable("force_software_renderer",   &force_software_renderer);
     M_BindIntVariable("max_scaling_buffer_pixels", &max_scaling_buffer_pixels);
+    M_BindIntVariable("video_upscale",             &video_upscale);
     M_BindIntVariable("window_width",              &window_width);
     M_BindIntVariable("window_height",             &window_height);
     M_BindIntVariable("grabmouse",                 &grabmouse);
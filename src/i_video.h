@@ -51,6 +51,11 @@ void I_FinishUpdate (void);
 
 void I_ReadScreen (pixel_t* scr);
 
+// A view rendered larger than its window on the screen, shown in its
+// place where the screen is upscaled.  Good for the next frame only.
+void I_SetHiresView (const pixel_t *buffer, int pitch, int width, int height,
+                     int x, int y, int w, int h);
+
 void I_BeginRead (void);
 
 void I_SetWindowTitle(char *title);
@@ -513,6 +513,88 @@ static default_t	doom_defaults_list[] =
 
     CONFIG_VARIABLE_INT(screensize),
 
+    //!
+    // @game doom
+    //
+    // Number of threads used to draw the 3D view.  The view is split
+    // into vertical strips that are drawn in parallel, a value of 1
+    // draws it on the main thread only.
+    //
+
+    CONFIG_VARIABLE_INT(render_threads),
+
+    //!
+    // @game doom
+    //
+    // Size of the rendered view in percent (50-200) of the view
+    // window.  Smaller views are faster to draw and are stretched
+    // to fit, larger ones are sharper where the screen is upscaled.
+    //
+
+    CONFIG_VARIABLE_INT(render_scale),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, the render scale and the detail are lowered
+    // automatically while the game can not keep up with 35 frames
+    // per second, and raised again when it can.
+    //
+
+    CONFIG_VARIABLE_INT(render_governor),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, distant walls and flats are drawn from smaller,
+    // averaged copies of their textures.  Off by default, so that the
+    // output matches other ports pixel for pixel.
+    //
+
+    CONFIG_VARIABLE_INT(render_lod),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, the number of visplanes, drawsegs, sprites, columns,
+    // spans and pixels of each frame and the time spent in its BSP,
+    // plane and masked phases are shown on the screen, and reported
+    // once a second.
+    //
+
+    CONFIG_VARIABLE_INT(render_stats),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, the view shows how often each pixel was drawn in
+    // the frame instead of its color, from blue for once over green,
+    // yellow and red to white for eight times and more.
+    //
+
+    CONFIG_VARIABLE_INT(render_heatmap),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, the renderer leaves out what can not be seen from
+    // the sector of the view point, going by the potentially visible
+    // sets of sectors made when a level is loaded.  If zero, the sets
+    // are not made at all.
+    //
+
+    CONFIG_VARIABLE_INT(render_pvs),
+
+    //!
+    // @game doom
+    //
+    // If non-zero, frames are drawn as often as the display allows,
+    // with the view, the things and the moving sectors interpolated
+    // between game tics.  If zero, the frame rate is capped at 35.
+    //
+
+    CONFIG_VARIABLE_INT(uncapped),
+
     //!
     // @game doom
     //
@@ -783,6 +865,15 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(max_scaling_buffer_pixels),
 
+    //!
+    // Integer factor the screen is upscaled by on the CPU before it
+    // is stretched to the window.  Zero picks the smallest factor
+    // that covers the window, 1 leaves all scaling to the renderer
+    // and is the cheapest on slow devices.
+    //
+
+    CONFIG_VARIABLE_INT(video_upscale),
+
     //!
     // Number of milliseconds to wait on startup after the video mode
     // has been set, before the game will start.  This allows the
@@ -46,5 +46,22 @@ typedef PACKED_STRUCT (
 // column_t is a list of 0 or more post_t, (byte)-1 terminated
 typedef post_t	column_t;
 
+// [crispy] a patch decoded into its posts once, see V_DecodePatch(),
+// so that the drawers do not have to step through the post lists
+typedef struct
+{
+    int			topdelta;	// from the top, tall patches resolved
+    int			length;
+    byte		*pixels;	// into the patch
+} vpost_t;
+
+typedef struct
+{
+    const patch_t	*patch;		// decoded from
+    int			width;
+    vpost_t		*posts;
+    int			*columns;	// column x has posts [x] to [x+1]-1
+} vpatch_t;
+
 #endif 
 
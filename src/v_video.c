@@ -69,6 +69,19 @@ int dirtybox[4];
 // This is needed for Chocolate Strife, which clips patches to the screen.
 static vpatchclipfunc_t patchclip_callback = NULL;
 
+// [crispy] decoded patches by lump, and the lumps of the patches
+// looked up by their address
+typedef struct
+{
+    const patch_t *patch;
+    int lump;
+} vpatchkey_t;
+
+static vpatch_t **vpatches = NULL;
+static unsigned int numvpatches;
+static vpatchkey_t *vpatchkeys = NULL;
+static int numvpatchkeys, maxvpatchkeys;
+
 //
 // V_MarkRect 
 // 
@@ -143,6 +156,242 @@ void V_SetPatchClipCallback(vpatchclipfunc_t func)
     patchclip_callback = func;
 }
 
+//
+// V_DecodeColumns
+//
+// [crispy] Steps through the post lists of a patch once, into
+// vpatch->posts if it is given, and returns the number of posts.
+//
+static int V_DecodeColumns(const patch_t *patch, vpatch_t *vpatch)
+{
+    int numposts = 0;
+    int col, w;
+
+    w = SHORT(patch->width);
+
+    for (col = 0; col < w; col++)
+    {
+        const column_t *column;
+        int topdelta = -1;
+
+        column = (const column_t *)((const byte *)patch + LONG(patch->columnofs[col]));
+
+        if (vpatch)
+        {
+            vpatch->columns[col] = numposts;
+        }
+
+        while (column->topdelta != 0xff)
+        {
+            // [crispy] support for DeePsea tall patches
+            if (column->topdelta <= topdelta)
+            {
+                topdelta += column->topdelta;
+            }
+            else
+            {
+                topdelta = column->topdelta;
+            }
+
+            if (vpatch)
+            {
+                vpost_t *post = &vpatch->posts[numposts];
+
+                post->topdelta = topdelta;
+                post->length = column->length;
+                post->pixels = (byte *)column + 3;
+            }
+
+            numposts++;
+            column = (const column_t *)((const byte *)column + column->length + 4);
+        }
+    }
+
+    if (vpatch)
+    {
+        vpatch->columns[w] = numposts;
+    }
+
+    return numposts;
+}
+
+//
+// V_MakeVPatch
+//
+// [crispy] The decoded patch, its posts and the column indices are
+// kept in one block.  The pixels stay where they are in the patch.
+//
+static vpatch_t *V_MakeVPatch(const patch_t *patch, void *block)
+{
+    vpatch_t *vpatch;
+    int numposts, w;
+
+    w = SHORT(patch->width);
+    numposts = V_DecodeColumns(patch, NULL);
+
+    if (!block)
+    {
+        block = Z_Malloc(sizeof(*vpatch) + numposts * sizeof(vpost_t)
+                         + (w + 1) * sizeof(int), PU_STATIC, NULL);
+    }
+
+    vpatch = block;
+    vpatch->patch = patch;
+    vpatch->width = w;
+    vpatch->posts = (vpost_t *)(vpatch + 1);
+    vpatch->columns = (int *)(vpatch->posts + numposts);
+
+    V_DecodeColumns(patch, vpatch);
+
+    return vpatch;
+}
+
+//
+// V_DecodePatchNum
+//
+// [crispy] Returns the decoded form of a patch lump, which is made the
+// first time it is asked for.  The patch is the one the caller got
+// for the lump, from the WAD cache or a copy of it: should the lump
+// have been loaded to somewhere else since, it is decoded anew.
+// The renderer threads call it with the cache locked.
+//
+const vpatch_t *V_DecodePatchNum(int lump, const patch_t *patch)
+{
+    vpatch_t *vpatch;
+
+    if (numvpatches < numlumps)
+    {
+        vpatches = I_Realloc(vpatches, numlumps * sizeof(*vpatches));
+        memset(vpatches + numvpatches, 0,
+               (numlumps - numvpatches) * sizeof(*vpatches));
+        numvpatches = numlumps;
+    }
+
+    vpatch = vpatches[lump];
+
+    if (vpatch && vpatch->patch == patch)
+    {
+        return vpatch;
+    }
+
+    if (vpatch)
+    {
+        Z_Free(vpatch);
+    }
+
+    vpatches[lump] = V_MakeVPatch(patch, NULL);
+
+    return vpatches[lump];
+}
+
+//
+// V_LumpAddress
+//
+// [crispy] Where the lump is in memory, or NULL if it is not loaded.
+//
+static const void *V_LumpAddress(int lump)
+{
+    const lumpinfo_t *info = lumpinfo[lump];
+
+    if (info->wad_file->mapped != NULL)
+    {
+        return info->wad_file->mapped + info->position;
+    }
+
+    return info->cache;
+}
+
+static inline unsigned int V_PatchKeyHash(const patch_t *patch)
+{
+    return ((uintptr_t) patch >> 3) * 2654435761u;
+}
+
+static vpatchkey_t *V_PatchKey(const patch_t *patch)
+{
+    unsigned int i = V_PatchKeyHash(patch) & (maxvpatchkeys - 1);
+
+    while (vpatchkeys[i].patch && vpatchkeys[i].patch != patch)
+    {
+        i = (i + 1) & (maxvpatchkeys - 1);
+    }
+
+    return &vpatchkeys[i];
+}
+
+//
+// V_DecodePatch
+//
+// [crispy] Same as V_DecodePatchNum() for the drawers that are only
+// handed the patch: its lump is looked up by its address, which is
+// checked to still be that of the lump.  Patches which are not in
+// a lump at all are decoded into a scratch block each time.
+//
+const vpatch_t *V_DecodePatch(const patch_t *patch)
+{
+    static void *scratch = NULL;
+    static int scratchsize = 0;
+    vpatchkey_t *key;
+    int lump, size;
+
+    if (numvpatchkeys * 2 >= maxvpatchkeys)
+    {
+        vpatchkey_t *oldkeys = vpatchkeys;
+        int oldmax = maxvpatchkeys;
+        int i;
+
+        maxvpatchkeys = oldmax ? 2 * oldmax : 1024;
+        vpatchkeys = Z_Malloc(maxvpatchkeys * sizeof(*vpatchkeys), PU_STATIC, NULL);
+        memset(vpatchkeys, 0, maxvpatchkeys * sizeof(*vpatchkeys));
+
+        for (i = 0; i < oldmax; i++)
+        {
+            if (oldkeys[i].patch)
+            {
+                *V_PatchKey(oldkeys[i].patch) = oldkeys[i];
+            }
+        }
+
+        if (oldkeys)
+        {
+            Z_Free(oldkeys);
+        }
+    }
+
+    key = V_PatchKey(patch);
+
+    if (key->patch && V_LumpAddress(key->lump) == patch)
+    {
+        return V_DecodePatchNum(key->lump, patch);
+    }
+
+    for (lump = numlumps - 1; lump >= 0; lump--)
+    {
+        if (V_LumpAddress(lump) == patch)
+        {
+            if (!key->patch)
+            {
+                numvpatchkeys++;
+            }
+
+            key->patch = patch;
+            key->lump = lump;
+
+            return V_DecodePatchNum(lump, patch);
+        }
+    }
+
+    size = sizeof(vpatch_t) + V_DecodeColumns(patch, NULL) * sizeof(vpost_t)
+         + (SHORT(patch->width) + 1) * sizeof(int);
+
+    if (size > scratchsize)
+    {
+        scratch = I_Realloc(scratch, size);
+        scratchsize = size;
+    }
+
+    return V_MakeVPatch(patch, scratch);
+}
+
 //
 // V_DrawPatch
 // Masks a column based masked pic to the screen. 
@@ -167,7 +416,8 @@ static void V_DrawPatchCrispy(int x, int y, patch_t *patch, int r)
 { 
     int count;
     int col;
-    column_t *column;
+    const vpatch_t *vpatch;
+    const vpost_t *post, *lastpost;
     pixel_t *desttop;
     pixel_t *dest;
     byte *source;
@@ -207,11 +457,10 @@ static void V_DrawPatchCrispy(int x, int y, patch_t *patch, int r)
     desttop2 = dest_screen + (y + r) * SCREENWIDTH + (x + r);
 
     w = SHORT(patch->width);
+    vpatch = V_DecodePatch(patch);
 
     for ( ; col<w ; x++, col++, desttop++, desttop2++)
     {
-        int topdelta = -1;
-
         // [crispy] too far left
         if (x < 0)
         {
@@ -224,26 +473,18 @@ static void V_DrawPatchCrispy(int x, int y, patch_t *patch, int r)
             break;
         }
 
-        column = (column_t *)((byte *)patch + LONG(patch->columnofs[col]));
+        post = &vpatch->posts[vpatch->columns[col]];
+        lastpost = &vpatch->posts[vpatch->columns[col + 1]];
 
         // step through the posts in a column
-        while (column->topdelta != 0xff)
+        for ( ; post < lastpost; post++)
         {
             int top, srccol = 0;
-            // [crispy] support for DeePsea tall patches
-            if (column->topdelta <= topdelta)
-            {
-                topdelta += column->topdelta;
-            }
-            else
-            {
-                topdelta = column->topdelta;
-            }
-            top = y + topdelta;
-            source = (byte *)column + 3;
-            dest = desttop + topdelta * SCREENWIDTH;
-            dest2 = desttop2 + topdelta * SCREENWIDTH;
-            count = column->length;
+            top = y + post->topdelta;
+            source = post->pixels;
+            dest = desttop + post->topdelta * SCREENWIDTH;
+            dest2 = desttop2 + post->topdelta * SCREENWIDTH;
+            count = post->length;
 
             // [crispy] too low / height
             if (top + count > SCREENHEIGHT)
@@ -273,7 +514,6 @@ static void V_DrawPatchCrispy(int x, int y, patch_t *patch, int r)
                 srccol++;
                 dest += SCREENWIDTH;
             }
-            column = (column_t *)((byte *)column + column->length + 4);
         }
     }
 }
@@ -303,7 +543,8 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
 {
     int count;
     int col; 
-    column_t *column; 
+    const vpatch_t *vpatch;
+    const vpost_t *post, *lastpost;
     pixel_t *desttop;
     pixel_t *dest;
     byte *source; 
@@ -335,11 +576,10 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
     desttop = dest_screen + y * SCREENWIDTH + x;
 
     w = SHORT(patch->width);
+    vpatch = V_DecodePatch(patch);
 
     for ( ; col<w ; x++, col++, desttop++)
     {
-        int topdelta = -1;
-
         // [crispy] too far left
         if (x < 0)
         {
@@ -352,25 +592,17 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
             break;
         }
 
-        column = (column_t *)((byte *)patch + LONG(patch->columnofs[w-1-col]));
+        post = &vpatch->posts[vpatch->columns[w-1-col]];
+        lastpost = &vpatch->posts[vpatch->columns[w-col]];
 
         // step through the posts in a column
-        while (column->topdelta != 0xff )
+        for ( ; post < lastpost; post++)
         {
             int top, srccol = 0;
-            // [crispy] support for DeePsea tall patches
-            if (column->topdelta <= topdelta)
-            {
-                topdelta += column->topdelta;
-            }
-            else
-            {
-                topdelta = column->topdelta;
-            }
-            top = y + topdelta;
-            source = (byte *)column + 3;
-            dest = desttop + topdelta * SCREENWIDTH;
-            count = column->length;
+            top = y + post->topdelta;
+            source = post->pixels;
+            dest = desttop + post->topdelta * SCREENWIDTH;
+            count = post->length;
 
             // [crispy] too low / height
             if (top + count > SCREENHEIGHT)
@@ -394,7 +626,6 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
                 srccol++;
                 dest += SCREENWIDTH;
             }
-            column = (column_t *)((byte *)column + column->length + 4);
         }
     }
 }
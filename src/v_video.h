@@ -92,6 +92,10 @@ void V_DrawShadowedPatch(int x, int y, patch_t *patch);
 void V_DrawXlaPatch(int x, int y, patch_t * patch);     // villsa [STRIFE]
 void V_DrawPatchDirect(int x, int y, patch_t *patch);
 
+// [crispy] decoded patches, cached next to their lumps
+const vpatch_t *V_DecodePatchNum(int lump, const patch_t *patch);
+const vpatch_t *V_DecodePatch(const patch_t *patch);
+
 // Draw a linear block of pixels into the view buffer.
 
 void V_DrawBlock(int x, int y, int width, int height, pixel_t *src);